@@ -0,0 +1,87 @@
+/*
+ * Lexer throughput benchmark: lexes a generated source several times with the
+ * SSE2 lexer and with the scalar one (see lexer_scalar.cpp), and prints the
+ * throughputs in MB/s and the speedup.
+ *
+ * usage: lexer_bench [nb_functions] [nb_runs]
+ */
+#include "parser/lexer.hpp"
+// declaration of the scalar scanner (same class, other name)
+#undef LEXER_HPP
+#define Scanner ScalarScanner
+#include "parser/lexer.hpp"
+#undef Scanner
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// source similar to the preprocessor output (file markers, comments, strings)
+static std::string generate_source(size_t nb_functions) {
+    std::ostringstream oss;
+
+    oss << "-->bench.3-0\n";
+    for (size_t i = 0; i < nb_functions; ++i) {
+        oss << "~~~ function number " << i << " computes some values\n"
+            << "int function_" << i << "(int first_argument, flt second_argument) bgn\n"
+            << "    int counter\n"
+            << "    int accumulator[16]\n"
+            << "    mov(counter, 0)\n"
+            << "    for mov(counter, 0), inf(counter, 10), mov(counter, add(counter, 1)) bgn\n"
+            << "        mov(accumulator[counter], mul(first_argument, counter))\n"
+            << "    end\n"
+            << "    cnd eql(first_argument, 42) bgn\n"
+            << "        shw(\"the answer is \\\"42\\\"\\n\")\n"
+            << "    end otw bgn\n"
+            << "        shw(second_argument)\n"
+            << "        shw(-3.14159)\n"
+            << "    end\n"
+            << "    ret add(first_argument, 'c')\n"
+            << "end\n\n";
+    }
+    return oss.str();
+}
+
+// throughput in MB/s, the number of tokens per run is returned in `nb_tokens`
+template <typename S>
+static double lex_throughput(std::string const &source, size_t nb_runs,
+                             size_t &nb_tokens) {
+    nb_tokens = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t run = 0; run < nb_runs; ++run) {
+        S scanner(source);
+        parser::Parser::semantic_type yylval;
+        parser::Parser::location_type yylloc;
+        while (scanner.lex(&yylval, &yylloc) != 0) {
+            ++nb_tokens;
+        }
+    }
+    std::chrono::duration<double> duration =
+        std::chrono::steady_clock::now() - start;
+    nb_tokens /= nb_runs;
+    return (double)(source.size() * nb_runs) / (1024 * 1024) / duration.count();
+}
+
+int main(int argc, char **argv) {
+    size_t nb_functions = argc > 1 ? std::stoul(argv[1]) : 20000;
+    size_t nb_runs = argc > 2 ? std::stoul(argv[2]) : 10;
+    std::string source = generate_source(nb_functions);
+    size_t nb_tokens = 0;
+    size_t nb_scalar_tokens = 0;
+
+    double simd = lex_throughput<parser::Scanner>(source, nb_runs, nb_tokens);
+    double scalar = lex_throughput<parser::ScalarScanner>(source, nb_runs,
+                                                          nb_scalar_tokens);
+    if (nb_tokens != nb_scalar_tokens) {
+        std::cerr << "error: the lexers found " << nb_tokens << " and "
+                  << nb_scalar_tokens << " tokens." << std::endl;
+        return 1;
+    }
+
+    std::cout << "input: " << source.size() << " bytes, " << nb_tokens
+              << " tokens" << std::endl;
+    std::cout << "sse2:   " << simd << " MB/s" << std::endl;
+    std::cout << "scalar: " << scalar << " MB/s" << std::endl;
+    std::cout << "speedup: " << simd / scalar << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,11 @@
+/*
+ * Scalar version of the lexer (the same code compiled with LEXER_NO_SIMD),
+ * used as the baseline of the lexer benchmark. The scanner is renamed so both
+ * versions can be linked in the benchmark.
+ */
+#include "parser/parser.hpp" // the parser keeps using the real scanner
+#ifndef LEXER_NO_SIMD
+#define LEXER_NO_SIMD
+#endif
+#define Scanner ScalarScanner
+#include "parser/lexer.cpp"
@@ -0,0 +1,52 @@
+/*
+ * Scope lookup benchmark: builds a chain of nested scopes (a wide function
+ * with nested blocks) and looks up symbols defined at every depth from the
+ * innermost scope. Prints the time per lookup.
+ *
+ * usage: scope_bench [nb_symbols_per_scope] [depth] [nb_lookups]
+ */
+#include "scope.hpp"
+#include "tools/intern.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+    size_t nb_symbols = argc > 1 ? std::stoul(argv[1]) : 1000;
+    size_t depth = argc > 2 ? std::stoul(argv[2]) : 8;
+    size_t nb_lookups = argc > 3 ? std::stoul(argv[3]) : 10000000;
+    std::vector<Identifier> names;
+    std::vector<Symbol> symbols = {Symbol{}};
+    Scope *global_scope = scope_create();
+    Scope *scope = global_scope;
+
+    for (size_t d = 0; d < depth; ++d) {
+        scope = scope_add_child(scope, (AstId)(d + 1));
+        for (size_t i = 0; i < nb_symbols; ++i) {
+            Identifier name = intern("symbol_" + std::to_string(d) + "_" +
+                                     std::to_string(i));
+            scope_add_symbol(scope, &symbols, name, nullptr, AST_NULL,
+                             location_create(name.id, i));
+            names.push_back(name);
+        }
+    }
+
+    size_t found = 0;
+    size_t idx = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < nb_lookups; ++i) {
+        // visit the names in a scattered order (7919 is prime)
+        idx = (idx + 7919) % names.size();
+        found += scope_lookup_symbol(scope, names[idx]) != SYMBOL_NONE;
+    }
+    std::chrono::duration<double> duration =
+        std::chrono::steady_clock::now() - start;
+
+    std::cout << "scopes: " << depth << ", symbols: " << names.size()
+              << ", found: " << found << "/" << nb_lookups << std::endl;
+    std::cout << "lookup: " << duration.count() * 1e9 / (double)nb_lookups
+              << " ns" << std::endl;
+    scope_destroy(global_scope);
+    return 0;
+}
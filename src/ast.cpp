@@ -1,17 +1,26 @@
 #include "ast.hpp"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
-Location location_create(std::string const &filename, size_t row, size_t col) {
+Location location_create(IdentifierId file, size_t row, size_t col) {
     return Location{
-        .row = row,
-        .col = col,
-        .filename = filename,
+        .file = file,
+        .row = (uint32_t)row,
+        .col = (uint32_t)col,
     };
 }
 
+Location location_create(std::string_view filename, size_t row, size_t col) {
+    return location_create(intern(filename).id, row, col);
+}
+
+std::string_view location_filename(Location const &location) {
+    return intern_lookup(location.file).view();
+}
+
 std::ostream &operator<<(std::ostream &os, Location const &location) {
-    os << location.filename << '(' << location.row << ':' << location.col << ')';
+    os << location_filename(location) << '(' << location.row << ':' << location.col << ')';
     return os;
 }
 std::string operator_name(ArithmeticOperationKind kind) {
@@ -24,8 +33,38 @@ std::string operator_name(ArithmeticOperationKind kind) {
     return "unknown operator";
 }
 
-void print_ast(Ast *) {
-    std::cerr << "error: print_ast not implemented" << std::endl;
+// the memory of the arrays is kept so it can be reused
+void ast_storage_clear(AstStorage *asts) {
+    asts->kinds.resize(1);
+    asts->locations.resize(1);
+    asts->indices.resize(1);
+    asts->values.clear();
+    asts->variable_definitions.clear();
+    asts->variable_references.clear();
+    asts->assignments.clear();
+    asts->index_expressions.clear();
+    asts->functions.clear();
+    asts->function_calls.clear();
+    asts->cnd_stmts.clear();
+    asts->whl_stmts.clear();
+    asts->for_stmts.clear();
+    asts->ret_stmts.clear();
+    asts->blocks.clear();
+    asts->arithmetic_operations.clear();
+    asts->boolean_operations.clear();
+    asts->builtin_functions.clear();
 }
 
-#undef create_ast
+AstList ast_list_create(ArrayBuilder<AstId> builder, Allocator allocator) {
+    Array<AstId> array = array_builder_finish(builder, allocator);
+    return AstList{array.ptr, (uint32_t)array.len};
+}
+
+AstList ast_list_create(std::vector<AstId> const &ids, Allocator allocator) {
+    AstList list = {
+        .ptr = ids.empty() ? nullptr : alloc<AstId>(allocator, ids.size()),
+        .len = (uint32_t)ids.size(),
+    };
+    std::copy(ids.begin(), ids.end(), list.ptr);
+    return list;
+}
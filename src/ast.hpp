@@ -1,21 +1,27 @@
 #ifndef AST_H
 #define AST_H
 #include "tools/array.hpp"
+#include "tools/intern.hpp"
 #include "tools/string.hpp"
 #include "tools/mem.hpp"
+#include "tools/time_report.hpp"
 #include <cstddef>
 #include <string>
 #include <vector>
 #include <ostream>
 
+// The file names are stored in the global identifiers table, so the location
+// only holds the id of the file and can be trivially copied.
 struct Location {
-    size_t row;
-    size_t col;
-    std::string filename;
+    IdentifierId file;
+    uint32_t row;
+    uint32_t col;
 };
 
-Location location_create(std::string const &filename, size_t row,
+Location location_create(IdentifierId file, size_t row, size_t col = 0);
+Location location_create(std::string_view filename, size_t row,
                          size_t col = 0);
+std::string_view location_filename(Location const &location);
 std::ostream &operator<<(std::ostream &os, Location const &location);
 
 enum class TypeSpecifierKind {
@@ -28,14 +34,42 @@ enum class TypeSpecifierKind {
 };
 struct TypeSpecifier {
     TypeSpecifierKind kind;
-    String name;
+    Identifier name;
     size_t size; // size used for arrays (we only support 1D static arrays for now)
 };
 
-struct Ast;
-struct Block;
+/*
+ * The nodes are stored in typed arrays (one per kind of node) and referenced
+ * with 32 bits handles. The kind, the location and the index of each node in
+ * the array of its kind are stored in dense arrays indexed by the handle, so
+ * the passes that only look at the kinds or at the locations do not load the
+ * nodes.
+ */
+using AstId = uint32_t;
 
-enum class AstKind {
+// the id 0 is never used by a node (it is used for the empty children)
+#define AST_NULL 0
+
+// Index of a symbol in the symbols of the program (see scope.hpp). The
+// references and the definitions are bound to their symbol by the resolution
+// pass, SYMBOL_NONE is used for the names that cannot be resolved.
+using SymbolId = uint32_t;
+#define SYMBOL_NONE 0
+
+// list of children (the ids are stored in the state allocator)
+struct AstList {
+    AstId *ptr;
+    uint32_t len;
+
+    AstId operator[](size_t i) const {
+        assert(i < len && "error: index out of bound.");
+        return ptr[i];
+    }
+    AstId const *begin() const { return ptr; }
+    AstId const *end() const { return ptr + len; }
+};
+
+enum class AstKind : uint8_t {
     Value,
     // variable
     VariableDefinition,
@@ -76,59 +110,63 @@ struct Value {
 
 struct VariableDefinition {
     TypeSpecifier type_specifier;
-    String name;
+    Identifier name;
+    SymbolId symbol;
 };
 
 struct VariableReference {
-    String name;
+    Identifier name;
+    SymbolId symbol;
 };
 
 struct Assignment {
-    Ast *target;
-    Ast *value;
+    AstId target;
+    AstId value;
 };
 
 struct IndexExpression {
-    Ast *element;
-    Ast *index;
+    AstId element;
+    AstId index;
 };
 
 struct Function {
     TypeSpecifier return_type_specifier;
-    String name;
-    Array<Ast *> arguments = {};
-    Ast *body;
+    Identifier name;
+    AstList arguments;
+    AstId body; // AST_NULL for declarations
+    SymbolId symbol;
 };
 
 struct FunctionCall {
-    String name;
-    Array<Ast *> arguments = {};
+    Identifier name;
+    AstList arguments;
+    SymbolId symbol;
 };
 
 struct CndStmt {
-    Ast *condition;
-    Ast *block;
-    Ast *otw;
+    AstId condition;
+    AstId block;
+    AstId otw;
 };
 
 struct WhlStmt {
-    Ast *condition;
-    Ast *block;
+    AstId condition;
+    AstId block;
 };
 
 struct ForStmt {
-    Ast *init;
-    Ast *condition;
-    Ast *step;
-    Ast *block;
+    AstId init;
+    AstId condition;
+    AstId step;
+    AstId block;
 };
 
 struct RetStmt {
-    Ast *expression;
+    AstId expression;
 };
 
 struct Block {
-    Array<Ast *> asts = {};
+    AstList asts;
 };
 
 enum ArithmeticOperationKind {
@@ -139,8 +177,8 @@ enum ArithmeticOperationKind {
 };
 struct ArithmeticOperation {
     ArithmeticOperationKind kind;
-    Ast *lhs;
-    Ast *rhs;
+    AstId lhs;
+    AstId rhs;
 };
 
 enum BooleanOperationKind {
@@ -158,8 +196,8 @@ enum BooleanOperationKind {
 };
 struct BooleanOperation {
     BooleanOperationKind kind;
-    Ast *lhs;
-    Ast *rhs;
+    AstId lhs;
+    AstId rhs;
 };
 
 enum BuiltinFunctionKind {
@@ -168,43 +206,102 @@ enum BuiltinFunctionKind {
 };
 struct BuiltinFunction {
     BuiltinFunctionKind kind;
-    Ast *argument;
+    AstId argument;
 };
 
-union AstData {
-    Value value;
-    VariableDefinition variable_definition;
-    VariableReference variable_reference;
-    Assignment assignment;
-    IndexExpression index_expression;
-    Function function;
-    FunctionCall function_call;
-    CndStmt cnd_stmt;
-    WhlStmt whl_stmt;
-    ForStmt for_stmt;
-    RetStmt ret_stmt;
-    Block block;
-    ArithmeticOperation arithmetic_operation;
-    BooleanOperation boolean_operation;
-    BuiltinFunction builtin_function;
+struct AstStorage {
+    // indexed by the ids (the first element is a placeholder for AST_NULL)
+    std::vector<AstKind> kinds = {AstKind::Value};
+    std::vector<Location> locations = {Location{}};
+    std::vector<uint32_t> indices = {0};
+    // nodes
+    std::vector<Value> values;
+    std::vector<VariableDefinition> variable_definitions;
+    std::vector<VariableReference> variable_references;
+    std::vector<Assignment> assignments;
+    std::vector<IndexExpression> index_expressions;
+    std::vector<Function> functions;
+    std::vector<FunctionCall> function_calls;
+    std::vector<CndStmt> cnd_stmts;
+    std::vector<WhlStmt> whl_stmts;
+    std::vector<ForStmt> for_stmts;
+    std::vector<RetStmt> ret_stmts;
+    std::vector<Block> blocks;
+    std::vector<ArithmeticOperation> arithmetic_operations;
+    std::vector<BooleanOperation> boolean_operations;
+    std::vector<BuiltinFunction> builtin_functions;
 };
 
-struct Ast {
-    Location location;
-    AstKind kind;
-    AstData data;
-};
+// kind of the nodes of type T and array in which they are stored
+template <typename T>
+struct AstNodes;
 
-std::string operator_name(ArithmeticOperationKind kind);
-void print_ast(Ast *ast);
-
-inline Ast *new_ast_(MemPool<Ast> *pool, Location loc, AstKind kind, AstData data) {
-    return mem_pool_alloc(pool, Ast{
-        .location = loc,
-        .kind = kind,
-        .data = data,
-    });
+#define AST_NODES(type, array)                                                 \
+    template <>                                                                \
+    struct AstNodes<type> {                                                    \
+        static constexpr AstKind kind = AstKind::type;                         \
+        static std::vector<type> &get(AstStorage *asts) { return asts->array; } \
+        static std::vector<type> const &get(AstStorage const *asts) {          \
+            return asts->array;                                                \
+        }                                                                      \
+    };
+AST_NODES(Value, values)
+AST_NODES(VariableDefinition, variable_definitions)
+AST_NODES(VariableReference, variable_references)
+AST_NODES(Assignment, assignments)
+AST_NODES(IndexExpression, index_expressions)
+AST_NODES(Function, functions)
+AST_NODES(FunctionCall, function_calls)
+AST_NODES(CndStmt, cnd_stmts)
+AST_NODES(WhlStmt, whl_stmts)
+AST_NODES(ForStmt, for_stmts)
+AST_NODES(RetStmt, ret_stmts)
+AST_NODES(Block, blocks)
+AST_NODES(ArithmeticOperation, arithmetic_operations)
+AST_NODES(BooleanOperation, boolean_operations)
+AST_NODES(BuiltinFunction, builtin_functions)
+#undef AST_NODES
+
+void ast_storage_clear(AstStorage *asts);
+
+template <typename T>
+AstId new_ast(AstStorage *asts, Location location, T const &node) {
+    auto &nodes = AstNodes<T>::get(asts);
+    AstId id = (AstId)asts->kinds.size();
+
+    time_report_count(Counter::AstNodes);
+    asts->kinds.push_back(AstNodes<T>::kind);
+    asts->locations.push_back(location);
+    asts->indices.push_back((uint32_t)nodes.size());
+    nodes.push_back(node);
+    return id;
 }
-#define new_ast(pool, loc, kind, ...) new_ast_((pool), (loc), (kind), AstData{__VA_ARGS__})
+
+// Note: the references are invalidated when a node of the same type is added.
+template <typename T>
+T &ast_get(AstStorage *asts, AstId id) {
+    assert(id != AST_NULL && asts->kinds[id] == AstNodes<T>::kind);
+    return AstNodes<T>::get(asts)[asts->indices[id]];
+}
+
+template <typename T>
+T const &ast_get(AstStorage const *asts, AstId id) {
+    assert(id != AST_NULL && asts->kinds[id] == AstNodes<T>::kind);
+    return AstNodes<T>::get(asts)[asts->indices[id]];
+}
+
+inline AstKind ast_kind(AstStorage const *asts, AstId id) {
+    assert(id != AST_NULL);
+    return asts->kinds[id];
+}
+
+inline Location const &ast_location(AstStorage const *asts, AstId id) {
+    return asts->locations[id];
+}
+
+AstList ast_list_create(ArrayBuilder<AstId> builder, Allocator allocator);
+AstList ast_list_create(std::vector<AstId> const &ids, Allocator allocator);
+
+std::string operator_name(ArithmeticOperationKind kind);
 
 #endif
@@ -2,156 +2,142 @@
 #include "ast.hpp"
 #include "scope.hpp"
 #include "type.hpp"
+#include "tools/defer.hpp"
 #include "tools/messages.hpp"
-#include "tools/array.hpp"
+#include "tools/parallel.hpp"
+#include "tools/time_report.hpp"
 
-bool check(CheckState *state, Ast *ast, Scope *scope);
-bool check_block(CheckState *state, Ast *ast, Scope *scope);
-bool check_boolean_operation(CheckState *state, Ast *ast, Scope *scope);
+bool check(CheckState *state, AstId ast);
+bool check_block(CheckState *state, AstId ast);
+bool check_boolean_operation(CheckState *state, AstId ast);
 
-Type *type_specifier_to_type(CheckState *state, Scope *scope, TypeSpecifier const &specifier) {
-    Type *type = nullptr;
+Type *get_expr_type(CheckState *state, AstId expr) {
+    return (*state->expr_types)[expr];
+}
+
+void set_expr_type(CheckState *state, AstId expr, Type *type) {
+    (*state->expr_types)[expr] = type;
+}
 
-    switch (specifier.kind) {
-    case TypeSpecifierKind::Nil: type = state->global_scope->type_table["nil"].type; break;
-    case TypeSpecifierKind::Chr: type = state->global_scope->type_table["chr"].type; break;
-    case TypeSpecifierKind::Int: type = state->global_scope->type_table["int"].type; break;
-    case TypeSpecifierKind::Flt: type = state->global_scope->type_table["flt"].type; break;
-    case TypeSpecifierKind::Str: type = state->global_scope->type_table["str"].type; break;
-    case TypeSpecifierKind::Obj: type = scope_lookup_type(scope, specifier.name.ptr)->type; break;
-    }
-
-    // TODO: update this when we will support dynamic arrays
-    if (specifier.size > 0) {
-        return new_type(
-            state->type_pool,
-            TypeKind::Array,
-            .array = {
-                .element_type = type,
-                .size = specifier.size,
-                .dynamic = false,
-            },
-        );
-    }
-    return type;
+Symbol const &get_symbol(CheckState *state, SymbolId symbol) {
+    assert(symbol != SYMBOL_NONE && symbol < state->symbols->size());
+    return (*state->symbols)[symbol];
 }
 
-bool check_value(CheckState *state, Ast *ast, Scope *scope) {
+bool check_value(CheckState *state, AstId ast) {
     Type *type = nullptr;
 
-    switch (ast->data.value.kind) {
+    switch (ast_get<Value>(state->asts, ast).kind) {
     case ValueKind::Character:
-        type = new_type(state->type_pool, TypeKind::Primitive, .primitive = PrimitiveType::Chr);
+        type = type_primitive(state->types, PrimitiveType::Chr);
         break;
     case ValueKind::Integer:
-        type = new_type(state->type_pool, TypeKind::Primitive, .primitive = PrimitiveType::Int);
+        type = type_primitive(state->types, PrimitiveType::Int);
         break;
     case ValueKind::Real:
-        type = new_type(state->type_pool, TypeKind::Primitive, .primitive = PrimitiveType::Flt);
+        type = type_primitive(state->types, PrimitiveType::Flt);
         break;
     case ValueKind::String:
-        type = new_type(state->type_pool, TypeKind::Primitive, .primitive = PrimitiveType::Str);
+        type = type_primitive(state->types, PrimitiveType::Str);
         break;
     }
-    scope->expr_types[ast] = type;
+    set_expr_type(state, ast, type);
     return true;
 }
 
-bool check_variable_definition(CheckState *state, Ast *ast, Scope *scope) {
-    assert(ast->kind == AstKind::VariableDefinition);
-    std::string variable_name = std::string(ast->data.variable_definition.name.ptr);
+bool check_variable_definition(CheckState *state, AstId ast) {
+    auto const &definition = ast_get<VariableDefinition>(state->asts, ast);
+    Symbol const &sym = get_symbol(state, definition.symbol);
 
-    if (map_contains(scope->symbol_table, variable_name)) {
-        Symbol *sym = &scope->symbol_table[variable_name];
-        MULTIPLE_DEFINITION_ERROR(ast->location, variable_name, sym->location);
+    // the resolver binds the redefinitions to the first definition
+    if (sym.ast != ast) {
+        MULTIPLE_DEFINITION_ERROR(ast_location(state->asts, ast),
+                                  definition.name.ptr, sym.location);
         return false;
     }
-    Type *type = type_specifier_to_type(state, scope, ast->data.variable_definition.type_specifier);
-    scope_add_symbol(scope, variable_name, type, ast->location);
     return true;
 }
 
-bool check_variable_reference(CheckState *, Ast *ast, Scope *scope) {
-    assert(ast->kind == AstKind::VariableReference);
-    std::string variable_name = std::string(ast->data.variable_reference.name.ptr);
-    Symbol *sym = scope_lookup_symbol(scope, variable_name);
+bool check_variable_reference(CheckState *state, AstId ast) {
+    auto const &reference = ast_get<VariableReference>(state->asts, ast);
 
-    if (sym == nullptr) {
-        UNDEFINED_SYMBOL_ERROR(ast->location, variable_name);
+    if (reference.symbol == SYMBOL_NONE) {
+        UNDEFINED_SYMBOL_ERROR(ast_location(state->asts, ast), reference.name.ptr);
         return false;
     }
-    scope->expr_types[ast] = sym->type;
+    set_expr_type(state, ast, get_symbol(state, reference.symbol).type);
     return true;
 }
 
-bool check_assignment(CheckState *state, Ast *ast, Scope *scope) {
-    Ast *target = ast->data.assignment.target;
-    Ast *expr = ast->data.assignment.value;
+bool check_assignment(CheckState *state, AstId ast) {
+    Location const &location = ast_location(state->asts, ast);
+    AstId target = ast_get<Assignment>(state->asts, ast).target;
+    AstId expr = ast_get<Assignment>(state->asts, ast).value;
 
-    if (!check(state, expr, scope) || !check(state, target, scope)) {
+    if (!check(state, expr) || !check(state, target)) {
         return false;
     }
 
-    auto expr_type = scope_lookup_expr_type(scope, expr);
-    auto target_type = scope_lookup_expr_type(scope, target);
+    auto expr_type = get_expr_type(state, expr);
+    auto target_type = get_expr_type(state, target);
 
     if (!is_primitive(target_type)) { // may change
-        INVALID_MOV_ERROR(ast->location, target_type);
+        INVALID_MOV_ERROR(location, target_type);
         return false;
     }
     if (!is_convertible(expr_type, target_type)) {
-        BAD_ASSIGNMENT_ERROR(ast->location, expr_type, target_type);
+        BAD_ASSIGNMENT_ERROR(location, expr_type, target_type);
         return false;
     }
     if (!equal(expr_type, target_type)) {
-        IMPLICIT_CONVERTION_WARNING(ast->location, expr_type, target_type);
+        IMPLICIT_CONVERTION_WARNING(location, expr_type, target_type);
     }
     return true;
 }
 
-bool check_index_expr(CheckState *state, Ast *ast, Scope *scope) {
-    Ast *variable_ast = ast->data.index_expression.element;
-    Ast *index_ast = ast->data.index_expression.index;
+bool check_index_expr(CheckState *state, AstId ast) {
+    AstId variable_ast = ast_get<IndexExpression>(state->asts, ast).element;
+    AstId index_ast = ast_get<IndexExpression>(state->asts, ast).index;
 
-    if (!check(state, variable_ast, scope) || !check(state, index_ast, scope)) {
+    if (!check(state, variable_ast) || !check(state, index_ast)) {
         return false;
     }
 
-    auto variable_type = scope_lookup_expr_type(scope, variable_ast);
+    auto variable_type = get_expr_type(state, variable_ast);
     if (variable_type->kind != TypeKind::Array) {
-        INDEX_NON_ARRAY_TYPE_ERROR(ast->location, std::string(variable_ast->data.variable_reference.name.ptr));
+        INDEX_NON_ARRAY_TYPE_ERROR(
+            ast_location(state->asts, ast),
+            ast_get<VariableReference>(state->asts, variable_ast).name.ptr);
         return false;
     }
 
-    auto index_type = scope_lookup_expr_type(scope, index_ast);
+    auto index_type = get_expr_type(state, index_ast);
     if (!is_int(index_type)) {
-        INVALID_INDEX_TYPE_ERROR(index_ast->location, index_type);
+        INVALID_INDEX_TYPE_ERROR(ast_location(state->asts, index_ast), index_type);
         return false;
     }
-    scope->expr_types[ast] = variable_type->data.array.element_type;
+    set_expr_type(state, ast, variable_type->data.array.element_type);
     return true;
 }
 
-bool check_function_definition(CheckState *state, Ast *ast, Scope *scope) {
-    std::string function_name = std::string(ast->data.function.name.ptr);
-    Symbol *sym = scope_lookup_symbol(state->global_scope, function_name);
-    Scope *function_scope = scope_add_child(scope, ast);
+bool check_function_definition(CheckState *state, AstId ast) {
+    auto const &function = ast_get<Function>(state->asts, ast);
+    Symbol const &sym = get_symbol(state, function.symbol);
 
-    assert(sym != nullptr);
     state->curr_function = ast;
 
-    for (size_t i = 0; i < ast->data.function.arguments.len; ++i) {
-        check_variable_definition(state, ast->data.function.arguments[i], function_scope);
+    for (AstId argument : function.arguments) {
+        check_variable_definition(state, argument);
     }
-    if (!check_block(state, ast->data.function.body, function_scope)) {
+    if (!check_block(state, function.body)) {
         return false;
     }
-    Array<Ast *> body = ast->data.function.body->data.block.asts;
-    if (!is_nil(sym->type->data.function.return_type)
-            && (body.len == 0 || body[body.len - 1]->kind != AstKind::RetStmt)) {
-        Location loc = ast->location;
+    AstList body = ast_get<Block>(state->asts, function.body).asts;
+    if (!is_nil(sym.type->data.function.return_type)
+            && (body.len == 0 || ast_kind(state->asts, body[body.len - 1]) != AstKind::RetStmt)) {
+        Location loc = ast_location(state->asts, ast);
         if (body.len > 0) {
-            loc = body[body.len - 1]->location;
+            loc = ast_location(state->asts, body[body.len - 1]);
         }
         ERROR(loc, "missing return statement in a non nil function.")
         return false;
@@ -159,24 +145,26 @@ bool check_function_definition(CheckState *state, Ast *ast, Scope *scope) {
     return true;
 }
 
-bool check_function_call(CheckState *state, Ast *ast, Scope *scope) {
-    auto function_name = ast->data.function_call.name;
-    auto args = ast->data.function_call.arguments;
-    auto sym = scope_lookup_symbol(scope, function_name.ptr);
+bool check_function_call(CheckState *state, AstId ast) {
+    Location const &location = ast_location(state->asts, ast);
+    auto function_name = ast_get<FunctionCall>(state->asts, ast).name;
+    auto args = ast_get<FunctionCall>(state->asts, ast).arguments;
+    SymbolId symbol = ast_get<FunctionCall>(state->asts, ast).symbol;
 
-    if (sym == nullptr) {
-        UNDEFINED_SYMBOL_ERROR(ast->location, function_name.ptr);
+    if (symbol == SYMBOL_NONE) {
+        UNDEFINED_SYMBOL_ERROR(location, function_name.ptr);
         return false;
     }
+    Symbol const *sym = &get_symbol(state, symbol);
     if (sym->type->kind != TypeKind::Function) {
-        INVALID_CALL_ERROR(ast->location, function_name.ptr);
+        INVALID_CALL_ERROR(location, function_name.ptr);
         return false;
     }
 
     auto function_type = &sym->type->data.function;
-    scope->expr_types[ast] = function_type->return_type;
+    set_expr_type(state, ast, function_type->return_type);
     if (function_type->arguments_types.len != args.len) {
-        WRONG_NUMBER_OF_ARGUMENT_ERROR(ast->location, function_name.ptr,
+        WRONG_NUMBER_OF_ARGUMENT_ERROR(location, function_name.ptr,
                                        sym->type);
         return false;
     }
@@ -184,14 +172,14 @@ bool check_function_call(CheckState *state, Ast *ast, Scope *scope) {
     bool res = true;
     auto args_types = function_type->arguments_types;
     for (size_t idx = 0; idx < args.len; ++idx) {
-        if (!check(state, args[idx], scope)) {
+        if (!check(state, args[idx])) {
             return false;
         }
-        auto found_type = scope_lookup_expr_type(scope, args[idx]);
+        auto found_type = get_expr_type(state, args[idx]);
         auto expected_tpe = args_types[idx];
 
         if (!is_convertible(found_type, expected_tpe)) {
-            ARGUMENT_TYPE_ERROR(ast->location, function_name.ptr, idx,
+            ARGUMENT_TYPE_ERROR(location, function_name.ptr, idx,
                                 found_type, expected_tpe);
             res = false;
         }
@@ -199,35 +187,32 @@ bool check_function_call(CheckState *state, Ast *ast, Scope *scope) {
     return res;
 }
 
-bool check_cnd_stmt(CheckState *state, Ast *ast, Scope *scope) {
-    Ast *block = ast->data.cnd_stmt.block;
-    Ast *condition = ast->data.cnd_stmt.condition;
-    Ast *otw = ast->data.cnd_stmt.otw;
-    Scope *cnd_scope = scope_add_child(scope, ast);
+bool check_cnd_stmt(CheckState *state, AstId ast) {
+    auto const &cnd_stmt = ast_get<CndStmt>(state->asts, ast);
+    AstId block = cnd_stmt.block;
+    AstId condition = cnd_stmt.condition;
+    AstId otw = cnd_stmt.otw;
 
-    bool condition_ok = check_boolean_operation(state, condition, cnd_scope);
-    bool block_ok = check_block(state, block, cnd_scope);
-    bool otw_ok = otw != nullptr ? check(state, otw, scope) : true;
+    bool condition_ok = check_boolean_operation(state, condition);
+    bool block_ok = check_block(state, block);
+    bool otw_ok = otw != AST_NULL ? check(state, otw) : true;
     return condition_ok && block_ok && otw_ok;
 }
 
-bool check_for_stmt(CheckState *state, Ast *ast, Scope *scope) {
-    Location location = ast->location;
-    Ast *init = ast->data.for_stmt.init;
-    Ast *step = ast->data.for_stmt.step;
-    Ast *block = ast->data.for_stmt.block;
-    Scope *for_scope = scope_add_child(scope, ast);
+bool check_for_stmt(CheckState *state, AstId ast) {
+    Location location = ast_location(state->asts, ast);
+    AstId init = ast_get<ForStmt>(state->asts, ast).init;
+    AstId step = ast_get<ForStmt>(state->asts, ast).step;
+    AstId block = ast_get<ForStmt>(state->asts, ast).block;
 
-    if (!check(state, init, for_scope) || !check(state, step, for_scope)) {
+    if (!check(state, init) || !check(state, step)) {
         return false;
     }
 
-    assert(step->kind == AstKind::Assignment);
-
-    Ast *idx_var = init->data.assignment.target;
-    Symbol *idx_sym = scope_lookup_symbol(for_scope, idx_var->data.variable_reference.name.ptr);
-    Type *idx_var_type = idx_sym->type;
-    Type *step_type = scope_lookup_expr_type(for_scope, step->data.assignment.value);
+    AstId idx_var = ast_get<Assignment>(state->asts, init).target;
+    SymbolId idx_sym = ast_get<VariableReference>(state->asts, idx_var).symbol;
+    Type *idx_var_type = get_symbol(state, idx_sym).type;
+    Type *step_type = get_expr_type(state, ast_get<Assignment>(state->asts, step).value);
 
     if (!equal(idx_var_type, step_type)) {
         if (!is_convertible(idx_var_type, step_type)) {
@@ -237,104 +222,104 @@ bool check_for_stmt(CheckState *state, Ast *ast, Scope *scope) {
             FOR_STEP_TYPE_WARNING(location, step_type, idx_var_type);
         }
     }
-    return check_block(state, block, for_scope);
+    return check_block(state, block);
 }
 
-bool check_whl_stmt(CheckState *state, Ast *ast, Scope *scope) {
-    Ast *condition = ast->data.whl_stmt.condition;
-    Ast *block = ast->data.whl_stmt.block;
-    Scope *whl_scope = scope_add_child(scope, ast);
-    bool condition_ok = check_boolean_operation(state, condition, whl_scope);
-    bool block_ok = check_block(state, block, whl_scope);
+bool check_whl_stmt(CheckState *state, AstId ast) {
+    AstId condition = ast_get<WhlStmt>(state->asts, ast).condition;
+    AstId block = ast_get<WhlStmt>(state->asts, ast).block;
+    bool condition_ok = check_boolean_operation(state, condition);
+    bool block_ok = check_block(state, block);
     return condition_ok && block_ok;
 }
 
-bool check_ret_stmt(CheckState *state, Ast *ast, Scope *scope) {
-    std::string function_name = state->curr_function->data.function.name.ptr;
-    Symbol *sym = scope_lookup_symbol(scope, function_name);
-    assert(sym && "current function not inserted in the symbol table.");
+bool check_ret_stmt(CheckState *state, AstId ast) {
+    Location const &location = ast_location(state->asts, ast);
+    auto const &function = ast_get<Function>(state->asts, state->curr_function);
+    Identifier function_name = function.name;
+    Symbol const *sym = &get_symbol(state, function.symbol);
     auto expected_type = sym->type->data.function.return_type;
-    Ast *expr = ast->data.ret_stmt.expression;
+    AstId expr = ast_get<RetStmt>(state->asts, ast).expression;
 
-    if (is_nil(expected_type) && expr != nullptr) {
-        ERROR(ast->location, "value returned in " << QUOTE(function_name)
+    if (is_nil(expected_type) && expr != AST_NULL) {
+        ERROR(location, "value returned in " << QUOTE(function_name.ptr)
                 << " which should return nil.")
-    } else if (!is_nil(expected_type) && expr == nullptr) {
-        ERROR(ast->location, "invalid nil return in " << QUOTE(function_name)
+    } else if (!is_nil(expected_type) && expr == AST_NULL) {
+        ERROR(location, "invalid nil return in " << QUOTE(function_name.ptr)
                 << ", expected value of type "
                 << QUOTE(type_to_string(expected_type)) << ".")
     }
 
-    if (expr == nullptr) {
+    if (expr == AST_NULL) {
         return true;
     }
 
-    if (!check(state, expr, scope)) {
+    if (!check(state, expr)) {
         return false;
     }
 
-    auto expr_type = scope_lookup_expr_type(scope, expr);
+    auto expr_type = get_expr_type(state, expr);
     if (!is_convertible(expr_type, expected_type)) {
-        INVALID_RETURN_TYPE_ERROR(ast->location, function_name, expr_type,
+        INVALID_RETURN_TYPE_ERROR(location, function_name.ptr, expr_type,
                                   sym->type->data.function.return_type);
         return false;
     } else if (!equal(expr_type, expected_type)) {
-        IMPLICIT_CONVERTION_WARNING(ast->location, expr_type,
+        IMPLICIT_CONVERTION_WARNING(location, expr_type,
                                     sym->type->data.function.return_type);
     }
     return true;
 }
 
-bool check_block(CheckState *state, Ast *ast, Scope *scope) {
-    Scope *block_scope = scope_add_child(scope, ast);
+bool check_block(CheckState *state, AstId ast) {
     bool ok = true;
-    for (Ast *instruction : ast->data.block.asts) {
-        if (!check(state, instruction, block_scope)) {
+    for (AstId instruction : ast_get<Block>(state->asts, ast).asts) {
+        if (!check(state, instruction)) {
             ok = false;
         }
     }
     return ok;
 }
 
-bool check_arithmetic_operation(CheckState *state, Ast *ast, Scope *scope) {
-    Ast *lhs = ast->data.arithmetic_operation.lhs;
-    Ast *rhs = ast->data.arithmetic_operation.rhs;
+bool check_arithmetic_operation(CheckState *state, AstId ast) {
+    auto const &operation = ast_get<ArithmeticOperation>(state->asts, ast);
+    AstId lhs = operation.lhs;
+    AstId rhs = operation.rhs;
 
-    if (!check(state, lhs, scope) || !check(state, rhs, scope)) {
+    if (!check(state, lhs) || !check(state, rhs)) {
         return false;
     }
 
-    auto lhs_type = scope_lookup_expr_type(scope, lhs);
-    auto rhs_type = scope_lookup_expr_type(scope, rhs);
+    auto lhs_type = get_expr_type(state, lhs);
+    auto rhs_type = get_expr_type(state, rhs);
 
     if (!supports_arithmetic(lhs_type) || !supports_arithmetic(rhs_type)) {
-        ARITHMETIC_OPERATOR_ERROR(ast->location, operator_name(ast->data.arithmetic_operation.kind))
+        ARITHMETIC_OPERATOR_ERROR(ast_location(state->asts, ast), operator_name(operation.kind))
         return false;
     }
-    scope->expr_types[ast] = select_most_precise_arithmetic_type(lhs_type, rhs_type);
+    set_expr_type(state, ast, select_most_precise_arithmetic_type(lhs_type, rhs_type));
     return true;
 }
 
-bool check_boolean_operation(CheckState *state, Ast *ast, Scope *scope) {
-    Ast *lhs = ast->data.boolean_operation.lhs;
-    Ast *rhs = ast->data.boolean_operation.rhs;
+bool check_boolean_operation(CheckState *state, AstId ast) {
+    AstId lhs = ast_get<BooleanOperation>(state->asts, ast).lhs;
+    AstId rhs = ast_get<BooleanOperation>(state->asts, ast).rhs;
 
-    if (rhs == nullptr) {
-        return check(state, lhs, scope);
+    if (rhs == AST_NULL) {
+        return check(state, lhs);
     }
 
-    if (!check(state, lhs, scope) || !check(state, rhs, scope)) {
+    if (!check(state, lhs) || !check(state, rhs)) {
         return false;
     }
-    auto lhs_type = scope_lookup_expr_type(scope, lhs);
-    auto rhs_type = scope_lookup_expr_type(scope, rhs);
+    auto lhs_type = get_expr_type(state, lhs);
+    auto rhs_type = get_expr_type(state, rhs);
 
     assert(lhs_type != nullptr);
     assert(rhs_type != nullptr);
 
     if (!equal(lhs_type, rhs_type)) {
         if (is_convertible(lhs_type, rhs_type)) {
-            IMPLICIT_CONVERTION_WARNING(ast->location, lhs_type, rhs_type);
+            IMPLICIT_CONVERTION_WARNING(ast_location(state->asts, ast), lhs_type, rhs_type);
         } else {
             return false;
         }
@@ -343,17 +328,17 @@ bool check_boolean_operation(CheckState *state, Ast *ast, Scope *scope) {
     return true;
 }
 
-bool check_builtin_function(CheckState *state, Ast *ast, Scope *scope) {
-    Ast *arg = ast->data.builtin_function.argument;
+bool check_builtin_function(CheckState *state, AstId ast) {
+    AstId arg = ast_get<BuiltinFunction>(state->asts, ast).argument;
 
-    if (!check(state, arg, scope)) {
+    if (!check(state, arg)) {
         return false;
     }
 
-    if (ast->data.builtin_function.kind == BuiltinFunctionKind::Shw) {
-        auto expr_type = scope_lookup_expr_type(scope, arg);
+    if (ast_get<BuiltinFunction>(state->asts, ast).kind == BuiltinFunctionKind::Shw) {
+        auto expr_type = get_expr_type(state, arg);
         if (!is_str(expr_type)) {
-            ERROR(ast->location, "shw takes a string as argument.");
+            ERROR(ast_location(state->asts, ast), "shw takes a string as argument.");
             return false;
         }
         // TODO: this may change if in the future implementation of shw
@@ -362,116 +347,85 @@ bool check_builtin_function(CheckState *state, Ast *ast, Scope *scope) {
     return true;
 }
 
-bool check(CheckState *state, Ast *ast, Scope *scope) {
+bool check(CheckState *state, AstId ast) {
     bool ok = true;
 
-    if (ast == nullptr) {
-        std::cerr << "internal error: cannot check a nullptr ast." << std::endl;
+    if (ast == AST_NULL) {
+        msg::error("internal error: cannot check a null ast.");
         return false;
     }
 
-    switch (ast->kind) {
+    switch (ast_kind(state->asts, ast)) {
     case AstKind::Value:
-        ok = check_value(state, ast, scope);
+        ok = check_value(state, ast);
         break;
     case AstKind::VariableDefinition:
-        ok = check_variable_definition(state, ast, scope);
+        ok = check_variable_definition(state, ast);
         break;
     case AstKind::VariableReference:
-        ok = check_variable_reference(state, ast, scope);
+        ok = check_variable_reference(state, ast);
         break;
     case AstKind::Assignment:
-        ok = check_assignment(state, ast, scope);
+        ok = check_assignment(state, ast);
         break;
     case AstKind::IndexExpression:
-        ok = check_index_expr(state, ast, scope);
+        ok = check_index_expr(state, ast);
         break;
     case AstKind::Function:
-        if (ast->data.function.body != nullptr) {
-            ok = check_function_definition(state, ast, scope);
+        if (ast_get<Function>(state->asts, ast).body != AST_NULL) {
+            ok = check_function_definition(state, ast);
         }
         break;
     case AstKind::FunctionCall:
-        ok = check_function_call(state, ast, scope);
+        ok = check_function_call(state, ast);
         break;
     case AstKind::CndStmt:
-        ok = check_cnd_stmt(state, ast, scope);
+        ok = check_cnd_stmt(state, ast);
         break;
     case AstKind::WhlStmt:
-        ok = check_whl_stmt(state, ast, scope);
+        ok = check_whl_stmt(state, ast);
         break;
     case AstKind::ForStmt:
-        ok = check_for_stmt(state, ast, scope);
+        ok = check_for_stmt(state, ast);
         break;
     case AstKind::RetStmt:
-        ok = check_ret_stmt(state, ast, scope);
+        ok = check_ret_stmt(state, ast);
         break;
     case AstKind::Block: {
-        check_block(state, ast, scope);
+        check_block(state, ast);
     } break;
     case AstKind::ArithmeticOperation:
-        ok = check_arithmetic_operation(state, ast, scope);
+        ok = check_arithmetic_operation(state, ast);
         break;
     case AstKind::BooleanOperation:
-        ok = check_boolean_operation(state, ast, scope);
+        ok = check_boolean_operation(state, ast);
         break;
     case AstKind::BuiltinFunction:
-        ok = check_builtin_function(state, ast, scope);
+        ok = check_builtin_function(state, ast);
         break;
     }
     return ok;
 }
 
-Type *function_type_from_ast(CheckState *state, Scope *scope, Ast *ast) {
-    assert(ast->kind == AstKind::Function);
-    Type *return_type = type_specifier_to_type(state, scope, ast->data.function.return_type_specifier);
-    size_t nb_args = ast->data.function.arguments.len;
-    Array<Type *> arguments_types = array_create<Type *>(nb_args, nb_args, state->allocator);
-
-    for (size_t i = 0; i < ast->data.function.arguments.len; ++i) {
-        Ast *arg = ast->data.function.arguments[i];
-        assert(arg->kind == AstKind::VariableDefinition);
-        arguments_types[i] = type_specifier_to_type(state, scope, arg->data.variable_definition.type_specifier);
-    }
-    return new_type(
-        state->type_pool,
-        TypeKind::Function,
-        .function = {
-            .return_type = return_type,
-            .arguments_types = arguments_types,
-        }
-    );
-}
-
-// First pass in which global symbols are added to the symbol table.
-bool process_global_symbols(CheckState *state, std::vector<Ast *> const &program, Scope *global_scope) {
-    for (Ast *ast : program) {
-        assert(ast->kind == AstKind::Function);
-        std::string function_name = std::string(ast->data.function.name.ptr);
-        Symbol *sym = scope_lookup_symbol(global_scope, function_name);
-
-        if (sym != nullptr) {
-            MULTIPLE_DEFINITION_ERROR(ast->location, function_name, sym->location);
-            return false;
-        }
-        Type *function_type = function_type_from_ast(state, global_scope, ast);
-        scope_add_symbol(global_scope, function_name, function_type, ast->location);
-    }
-    return true;
-}
-
-// TODO: we should create the symbol table here
+// The functions only depend on the symbols and on the types created by the
+// resolver (the checker does not allocate), so they are checked in parallel
+// with one copy of the state per function. The messages of each function are
+// buffered and printed in the order of the program.
 bool check(CheckState *state, Program const &program) {
-    bool ok = true;
-
-    if (!process_global_symbols(state, program.code, program.scope)) {
-        return false;
-    }
-
-    for (Ast *ast : program.code) {
-        if (!check(state, ast, program.scope)) {
-            ok = false;
-        }
-    }
-    return ok;
+    PhaseTimer timer(Phase::Check);
+    std::vector<char> results(program.code.size(), true);
+    std::vector<std::string> messages(program.code.size());
+
+    // the types of the nodes are reset so the program can be checked again
+    state->expr_types->assign(state->asts->kinds.size(), nullptr);
+    parallel_for(program.code.size(), state->jobs, [&](size_t idx) {
+        CheckState function_state = *state;
+        std::string *previous = msg::capture(&messages[idx]);
+        defer(msg::capture(previous));
+        results[idx] = check(&function_state, program.code[idx]);
+    });
+    for (auto const &function_messages : messages) {
+        msg::print(function_messages);
+    }
+    return std::find(results.begin(), results.end(), false) == results.end();
 }
@@ -5,18 +5,19 @@
 #include "ast.hpp"
 #include "scope.hpp"
 #include "program.hpp"
-#include "tools/mem.hpp"
 
 /*
  * This module contains function that verify the types and the symbol
- * definitions.
+ * definitions. The program must be resolved first (see resolve.hpp).
  */
 
 struct CheckState {
-    Ast *curr_function;
-    MemPool<Type> *type_pool;
-    Allocator allocator;
-    Scope *global_scope;
+    AstId curr_function;
+    TypeTable *types;
+    AstStorage const *asts;
+    std::vector<Type *> *expr_types;    // indexed by the ast ids
+    std::vector<Symbol> const *symbols; // filled by the resolver
+    size_t jobs; // number of threads used to check the functions
 };
 
 bool check(CheckState *state, Program const &program);
@@ -0,0 +1,139 @@
+#include "cache.hpp"
+#include "tools/hash.hpp"
+#include <cstring>
+#include <elf.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <link.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace compiler {
+
+// GNU build id of the executable (hash of its code computed by the linker),
+// read from the loaded notes (the binary is not read again)
+static int find_build_id(dl_phdr_info *info, size_t, void *data) {
+    auto build_id = (std::string *)data;
+
+    for (size_t i = 0; i < info->dlpi_phnum; ++i) {
+        ElfW(Phdr) const &phdr = info->dlpi_phdr[i];
+        if (phdr.p_type != PT_NOTE) {
+            continue;
+        }
+        auto note = (uint8_t const *)(info->dlpi_addr + phdr.p_vaddr);
+        auto notes_end = note + phdr.p_memsz;
+        while (note + sizeof(ElfW(Nhdr)) <= notes_end) {
+            auto header = (ElfW(Nhdr) const *)note;
+            auto name = note + sizeof(ElfW(Nhdr));
+            auto desc = name + ((header->n_namesz + 3) & ~3u);
+            if (header->n_type == NT_GNU_BUILD_ID && header->n_namesz == 4 &&
+                memcmp(name, "GNU", 4) == 0) {
+                build_id->assign((char const *)desc, header->n_descsz);
+                return 1;
+            }
+            note = desc + ((header->n_descsz + 3) & ~3u);
+        }
+    }
+    return 1; // the first object is the executable
+}
+
+// Identity of the running compiler, so the entries created by another build
+// of the compiler are never used (computed once per process). Without build
+// id, the size and the modification time of the executable are used.
+static uint64_t compiler_identity() {
+    static uint64_t const identity = []() {
+        std::string build_id;
+        dl_iterate_phdr(find_build_id, &build_id);
+        if (!build_id.empty()) {
+            return hash_bytes(build_id.data(), build_id.size());
+        }
+        struct stat st = {};
+        stat("/proc/self/exe", &st);
+        uint64_t hash = hash_bytes(&st.st_size, sizeof(st.st_size));
+        return hash_bytes(&st.st_mtim, sizeof(st.st_mtim), hash);
+    }();
+    return identity;
+}
+
+std::string cache_key(std::string const &unit,
+                      std::vector<std::string> const &flags) {
+    std::string const version = BUILD_CACHE_VERSION;
+    uint64_t identity = compiler_identity();
+    uint64_t hash = hash_bytes(&identity, sizeof(identity));
+    std::ostringstream oss;
+
+    hash = hash_bytes(version.data(), version.size() + 1, hash);
+
+    // the null characters separate the flags
+    for (auto const &flag : flags) {
+        hash = hash_bytes(flag.data(), flag.size() + 1, hash);
+    }
+    hash = hash_bytes(unit.data(), unit.size(), hash);
+    oss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return oss.str();
+}
+
+std::string cache_filename(std::string const &build_directory,
+                           std::string const &key) {
+    return (std::filesystem::path(build_directory) / "cache" / (key + ".o"))
+        .string();
+}
+
+static std::string messages_filename(std::string const &cache_file) {
+    return cache_file + ".msg";
+}
+
+bool cache_load(std::string const &cache_file, std::string const &obj_file,
+                std::string *messages) {
+    std::error_code err;
+
+    if (!std::filesystem::exists(cache_file, err)) {
+        return false;
+    }
+    if (!std::filesystem::copy_file(
+            cache_file, obj_file,
+            std::filesystem::copy_options::overwrite_existing, err)) {
+        return false;
+    }
+    // no message file when the unit did not report anything
+    std::ifstream file(messages_filename(cache_file), std::ios::binary);
+    if (file.good()) {
+        messages->assign(std::istreambuf_iterator<char>(file),
+                         std::istreambuf_iterator<char>());
+    }
+    return true;
+}
+
+// The files are written to temporary files first and then renamed, so
+// concurrent compilations never see a partially written cache entry. The
+// messages are stored before the object file, so they are present whenever
+// the object file is found.
+void cache_store(std::string const &obj_file, std::string const &cache_file,
+                 std::string const &messages) {
+    auto tmp_file = cache_file + ".tmp" + std::to_string(getpid());
+    std::error_code err;
+
+    std::filesystem::create_directories(
+        std::filesystem::path(cache_file).parent_path(), err);
+    if (!messages.empty()) {
+        std::ofstream file(tmp_file, std::ios::binary);
+        file << messages;
+        file.close();
+        if (!file.good()) {
+            return;
+        }
+        std::filesystem::rename(tmp_file, messages_filename(cache_file), err);
+        if (err) {
+            return;
+        }
+    }
+    if (std::filesystem::copy_file(
+            obj_file, tmp_file,
+            std::filesystem::copy_options::overwrite_existing, err)) {
+        std::filesystem::rename(tmp_file, cache_file, err);
+    }
+}
+
+} // end namespace compiler
@@ -0,0 +1,31 @@
+#ifndef COMPILER_CACHE
+#define COMPILER_CACHE
+#include <string>
+#include <vector>
+
+/*
+ * Build cache: the object files are stored in the build directory, indexed by
+ * a hash of the build id of the compiler, of the preprocessed unit and of the
+ * options that change the generated code. When the hash of a unit is found in the cache, the cached object
+ * file is used directly and the unit is not compiled. The messages reported
+ * while compiling the unit (warnings) are stored next to the object file and
+ * are given back when the entry is loaded.
+ */
+
+// must be changed whenever the generated code changes for the same input
+#define BUILD_CACHE_VERSION "s3c-cache-3"
+
+namespace compiler {
+
+std::string cache_key(std::string const &unit,
+                      std::vector<std::string> const &flags);
+std::string cache_filename(std::string const &build_directory,
+                           std::string const &key);
+bool cache_load(std::string const &cache_file, std::string const &obj_file,
+                std::string *messages);
+void cache_store(std::string const &obj_file, std::string const &cache_file,
+                 std::string const &messages);
+
+} // end namespace compiler
+
+#endif
@@ -1,5 +1,8 @@
 #include "compiler.hpp"
 #include "compiler/tools.hpp"
+#include "tools/time_report.hpp"
+#include "tools/messages.hpp"
+#include "x86_64_encoder.hpp"
 #include "x86_64_gnu_linux.hpp"
 #include <cstdlib>
 #include <filesystem>
@@ -21,8 +24,7 @@ std::string asm_addr(Address const &result) {
         return "[" + result.register_name + "]";
         break;
     case AddressingMode::Index:
-        std::cerr << "unimplemented " << __FILE__ << " " << __LINE__
-                  << std::endl;
+        msg::error("unimplemented addressing mode.");
         break;
     case AddressingMode::Based:
         if (result.offset < 0) {
@@ -70,31 +72,64 @@ void asm_addr_based(CompilerState *state, std::string base_name, int offset,
     state->last_expr_addr.type = type;
 }
 
-// TODO: return a bool
-void compile_x86_64(std::string const &filename, CompilerState *state,
-                    Platform platform, Program const &program) {
-    switch (platform) {
-    case Platform::GNULinux:
-        x86_64::gnu_linux::compile(state, program);
-        break;
+bool compile_x86_64(std::string const &filename, CompilerState *state,
+                    Platform platform, OutputFormat format,
+                    Program const &program, size_t jobs) {
+    std::vector<Asm> code;
+    {
+        PhaseTimer timer(Phase::Codegen);
+        switch (platform) {
+        case Platform::GNULinux:
+            code = x86_64::gnu_linux::compile(state, program, jobs);
+            break;
+        }
+        size_t nb_instructions = 0, nb_data = 0;
+        for (auto const &function_code : code) {
+            nb_instructions += function_code.instructions.size();
+            nb_data += function_code.data.size();
+        }
+        time_report_count(Counter::Instructions, nb_instructions);
+        time_report_count(Counter::Data, nb_data);
     }
-    asm_dump(state->code, filename);
+
+    switch (format) {
+    case OutputFormat::Assembly: {
+        PhaseTimer timer(Phase::AsmDump);
+        asm_dump(code, filename);
+    } break;
+    case OutputFormat::Object: {
+        PhaseTimer timer(Phase::Encode);
+        ObjectFile obj;
+        if (!x86_64::encode(code, obj)) {
+            return false;
+        }
+        return elf_dump(obj, filename);
+    } break;
+    }
+    return true;
 }
 
-void compile(std::string const &filename, Arch arch, Platform platform,
-             Program const &program) {
+bool compile(std::string const &filename, Arch arch, Platform platform,
+             OutputFormat format, Program const &program, size_t jobs) {
+    std::vector<Address> symbols_addresses(program.symbols->size());
     CompilerState state{
         .code = {},
-        .curr_function = nullptr,
-        .variables_addresses = {},
+        .asts = program.asts,
+        .expr_types = program.expr_types,
+        .symbols = program.symbols,
+        .symbols_addresses = &symbols_addresses,
+        .curr_function = AST_NULL,
+        .label_namespace = 0,
         .frame_offset = 0,
         .last_expr_addr = {},
+        .label_ids = {},
     };
     switch (arch) {
     case Arch::X86_64:
-        compile_x86_64(filename, &state, platform, program);
+        return compile_x86_64(filename, &state, platform, format, program, jobs);
         break;
     };
+    return false;
 }
 
 void asm_dump_global_symbols(Asm const &code, std::ofstream &fs) {
@@ -125,16 +160,23 @@ void asm_dump_data(Asm const &code, std::ofstream &fs) {
     }
 }
 
-void asm_dump(Asm const &code, std::string const &filename) {
+// the code of the functions is written in the order of the program
+void asm_dump(std::vector<Asm> const &code, std::string const &filename) {
     std::ofstream fs(filename);
 
     fs << ".intel_syntax noprefix" << std::endl;
     fs << ".text" << std::endl;
-    asm_dump_global_symbols(code, fs);
-    asm_dump_instructions(code, fs);
+    for (auto const &function_code : code) {
+        asm_dump_global_symbols(function_code, fs);
+    }
+    for (auto const &function_code : code) {
+        asm_dump_instructions(function_code, fs);
+    }
 
-    fs << ".data" << std::endl;
-    asm_dump_data(code, fs);
+    fs << ".section .rodata" << std::endl;
+    for (auto const &function_code : code) {
+        asm_dump_data(function_code, fs);
+    }
 }
 
 void asm_add_global_symbol(Asm &code, std::string const &name) {
@@ -163,38 +205,50 @@ void asm_add_data(Asm &code, std::string const &name, std::string const &type,
     code.data.push_back(Data{name, type, value});
 }
 
-std::string asm_create_data_id(Asm const &code, std::string const &name) {
+// The data ids and the labels are numbered per function and prefixed by the
+// namespace of the function, so the functions can be compiled separately.
+std::string asm_create_data_id(CompilerState *state, std::string const &name) {
     std::ostringstream oss;
-    oss << name << code.data.size();
+    oss << name << state->label_namespace << "_" << state->code.data.size();
     return oss.str();
 }
 
-void allocate_stack_variable(CompilerState *state, std::string const &id,
-                             size_t size, Type *type,
-                             std::string const &base_name) {
-    auto it = state->variables_addresses.find(id);
+// Labels are numbered in their creation order (instead of using the ids of the
+// nodes) so the generated code does not depend on how the nodes are stored.
+std::string asm_label_id(CompilerState *state, AstId node) {
+    auto it = state->label_ids.find(node);
 
-    if (it == state->variables_addresses.end()) {
-        state->variables_addresses[id] = {};
+    if (it == state->label_ids.end()) {
+        it = state->label_ids.insert({node, state->label_ids.size()}).first;
     }
+    return std::to_string(state->label_namespace) + "_" + std::to_string(it->second);
+}
+
+// types computed by the checker
+Type *get_expr_type(CompilerState *state, AstId expr) {
+    assert(expr < state->expr_types->size());
+    return (*state->expr_types)[expr];
+}
+
+void allocate_stack_variable(CompilerState *state, SymbolId symbol,
+                             size_t size, Type *type,
+                             std::string const &base_name) {
     Address addr;
     addr.addressing_mode = AddressingMode::Based;
     addr.offset = -state->frame_offset;
     addr.size = size;
     addr.type = type;
     addr.register_name = base_name;
-    state->variables_addresses[id].push(addr);
+    (*state->symbols_addresses)[symbol] = addr;
     state->frame_offset += (int)size;
 }
 
-Address get_address(CompilerState *state, std::string const &id) {
-    auto it = state->variables_addresses.find(id);
-
-    if (it == state->variables_addresses.end()) {
-        std::cerr << "error: unkown variable" << std::endl;
+Address get_address(CompilerState *state, SymbolId symbol) {
+    if (symbol == SYMBOL_NONE || symbol >= state->symbols_addresses->size()) {
+        msg::error("unkown variable.");
         return {};
     }
-    return it->second.top();
+    return (*state->symbols_addresses)[symbol];
 }
 
 } // end namespace compiler
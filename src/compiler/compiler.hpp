@@ -49,10 +49,17 @@ struct Address {
 
 struct CompilerState {
     Asm code;
-    Ast *curr_function;
-    std::map<std::string, std::stack<Address>> variables_addresses;
+    AstStorage const *asts;
+    std::vector<Type *> const *expr_types;
+    std::vector<Symbol> const *symbols;
+    // indexed by the symbol ids, shared by the functions compiled in parallel
+    // (a symbol belongs to only one function)
+    std::vector<Address> *symbols_addresses;
+    AstId curr_function;
+    size_t label_namespace; // prefix of the labels and data ids of a function
     signed int frame_offset;
     Address last_expr_addr;
+    std::map<AstId, size_t> label_ids;
 };
 
 enum class Arch {
@@ -63,8 +70,13 @@ enum class Platform {
     GNULinux,
 };
 
-void compile(std::string const &filename, Arch arch, Platform platform,
-             Program const &program);
+enum class OutputFormat {
+    Assembly, // text assembly (intel syntax)
+    Object,   // relocatable object file
+};
+
+bool compile(std::string const &filename, Arch arch, Platform platform,
+             OutputFormat format, Program const &program, size_t jobs = 1);
 
 std::string asm_addr(Address const &result);
 void asm_addr_immediate_value(CompilerState *state, std::string value,
@@ -76,7 +88,7 @@ void asm_addr_register_indirect(CompilerState *state, std::string register_name,
 void asm_addr_based(CompilerState *state, std::string base_name, int offset,
                     Type *type);
 
-void asm_dump(Asm const &code, std::string const &filename);
+void asm_dump(std::vector<Asm> const &code, std::string const &filename);
 void asm_add_global_symbol(Asm &code, std::string const &name);
 void asm_add_label(Asm &code, std::string const &label);
 void asm_add_instruction(Asm &code, std::string const &instruction,
@@ -86,12 +98,14 @@ void asm_comment_last_instruction(Asm &code, std::string const &comment);
 void asm_add_comment_line(Asm &code, std::string const &comment);
 void asm_add_data(Asm &code, std::string const &name, std::string const &type,
                   std::string const &value);
-std::string asm_create_data_id(Asm const &code, std::string const &name);
+std::string asm_create_data_id(CompilerState *state, std::string const &name);
+std::string asm_label_id(CompilerState *state, AstId node);
+Type *get_expr_type(CompilerState *state, AstId expr);
 
-void allocate_stack_variable(CompilerState *state, std::string const &id,
+void allocate_stack_variable(CompilerState *state, SymbolId symbol,
                              size_t size, Type *type,
                              std::string const &base_name);
-Address get_address(CompilerState *state, std::string const &id);
+Address get_address(CompilerState *state, SymbolId symbol);
 
 } // end namespace compiler
 
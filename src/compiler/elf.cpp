@@ -0,0 +1,308 @@
+#include "elf.hpp"
+#include "tools/messages.hpp"
+#include <cassert>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+namespace compiler {
+
+/*
+ * Sections of the generated relocatable object (the order matters since the
+ * indices are used in the symbol table and in the section headers).
+ */
+enum ElfSectionIndex {
+    ShNull = 0,
+    ShText,
+    ShRodata,
+    ShNoteGnuStack,
+    ShSymtab,
+    ShStrtab,
+    ShRelaText,
+    ShShstrtab,
+    ShCount,
+};
+
+struct ElfStringTable {
+    std::vector<char> data = {0};
+
+    uint32_t add(std::string const &str) {
+        uint32_t idx = (uint32_t)data.size();
+        data.insert(data.end(), str.begin(), str.end());
+        data.push_back(0);
+        return idx;
+    }
+};
+
+static uint16_t elf_section_index(ObjSection section) {
+    switch (section) {
+    case ObjSection::Undefined: return SHN_UNDEF;
+    case ObjSection::Text: return ShText;
+    case ObjSection::Rodata: return ShRodata;
+    }
+    return SHN_UNDEF;
+}
+
+static void elf_write_padding(std::vector<uint8_t> &out, size_t align) {
+    while (out.size() % align != 0) {
+        out.push_back(0);
+    }
+}
+
+template <typename T>
+static void elf_write(std::vector<uint8_t> &out, T const &value) {
+    auto bytes = (uint8_t const *)&value;
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+bool elf_dump(ObjectFile const &obj, std::string const &filename) {
+    ElfStringTable strtab;
+    ElfStringTable shstrtab;
+    std::vector<Elf64_Sym> symbols;
+    std::vector<Elf64_Rela> relocations;
+    std::map<std::string, uint32_t> symbols_indices;
+
+    // symbol table: locals first (null symbol and section symbols), then globals
+    symbols.push_back(Elf64_Sym{});
+    for (uint16_t section : {ShText, ShRodata}) {
+        Elf64_Sym sym = {};
+        sym.st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+        sym.st_shndx = section;
+        symbols.push_back(sym);
+    }
+    uint32_t first_global = 0;
+    for (bool global : {false, true}) {
+        if (global) {
+            first_global = (uint32_t)symbols.size();
+        }
+        for (auto const &obj_sym : obj.symbols) {
+            if (obj_sym.global != global) {
+                continue;
+            }
+            Elf64_Sym sym = {};
+            sym.st_name = strtab.add(obj_sym.name);
+            sym.st_info = (unsigned char)ELF64_ST_INFO(
+                global ? STB_GLOBAL : STB_LOCAL, STT_NOTYPE);
+            sym.st_shndx = elf_section_index(obj_sym.section);
+            sym.st_value = obj_sym.offset;
+            symbols_indices[obj_sym.name] = (uint32_t)symbols.size();
+            symbols.push_back(sym);
+        }
+    }
+
+    for (auto const &obj_rel : obj.relocations) {
+        assert(obj_rel.section == ObjSection::Text);
+        auto it = symbols_indices.find(obj_rel.symbol);
+        if (it == symbols_indices.end()) {
+            msg::error("relocation to unknown symbol " + obj_rel.symbol +
+                       ".");
+            return false;
+        }
+        Elf64_Rela rela = {};
+        rela.r_offset = obj_rel.offset;
+        rela.r_info = ELF64_R_INFO((uint64_t)it->second, obj_rel.type);
+        rela.r_addend = obj_rel.addend;
+        relocations.push_back(rela);
+    }
+
+    // section contents (the file header is written at the end)
+    std::vector<uint8_t> out(sizeof(Elf64_Ehdr), 0);
+    Elf64_Shdr sections[ShCount] = {};
+
+    auto add_section = [&](ElfSectionIndex idx, char const *name,
+                           uint32_t type, uint64_t flags, void const *data,
+                           size_t size, size_t align, size_t entsize) {
+        elf_write_padding(out, align);
+        sections[idx].sh_name = shstrtab.add(name);
+        sections[idx].sh_type = type;
+        sections[idx].sh_flags = flags;
+        sections[idx].sh_offset = out.size();
+        sections[idx].sh_size = size;
+        sections[idx].sh_addralign = align;
+        sections[idx].sh_entsize = entsize;
+        auto bytes = (uint8_t const *)data;
+        out.insert(out.end(), bytes, bytes + size);
+    };
+
+    add_section(ShText, ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR,
+                obj.text.data(), obj.text.size(), 16, 0);
+    add_section(ShRodata, ".rodata", SHT_PROGBITS, SHF_ALLOC,
+                obj.rodata.data(), obj.rodata.size(), 8, 0);
+    add_section(ShNoteGnuStack, ".note.GNU-stack", SHT_PROGBITS, 0, nullptr,
+                0, 1, 0);
+    add_section(ShSymtab, ".symtab", SHT_SYMTAB, 0, symbols.data(),
+                symbols.size() * sizeof(Elf64_Sym), 8, sizeof(Elf64_Sym));
+    sections[ShSymtab].sh_link = ShStrtab;
+    sections[ShSymtab].sh_info = first_global;
+    add_section(ShStrtab, ".strtab", SHT_STRTAB, 0, strtab.data.data(),
+                strtab.data.size(), 1, 0);
+    add_section(ShRelaText, ".rela.text", SHT_RELA, SHF_INFO_LINK,
+                relocations.data(), relocations.size() * sizeof(Elf64_Rela), 8,
+                sizeof(Elf64_Rela));
+    sections[ShRelaText].sh_link = ShSymtab;
+    sections[ShRelaText].sh_info = ShText;
+    // the name of .shstrtab must be added before its content is written
+    sections[ShShstrtab].sh_name = shstrtab.add(".shstrtab");
+    sections[ShShstrtab].sh_type = SHT_STRTAB;
+    sections[ShShstrtab].sh_offset = out.size();
+    sections[ShShstrtab].sh_size = shstrtab.data.size();
+    sections[ShShstrtab].sh_addralign = 1;
+    out.insert(out.end(), shstrtab.data.begin(), shstrtab.data.end());
+
+    // section headers
+    elf_write_padding(out, 8);
+    size_t shoff = out.size();
+    for (auto const &section : sections) {
+        elf_write(out, section);
+    }
+
+    // file header
+    Elf64_Ehdr header = {};
+    memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = ET_REL;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_shoff = shoff;
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shnum = ShCount;
+    header.e_shstrndx = ShShstrtab;
+    memcpy(out.data(), &header, sizeof(Elf64_Ehdr));
+
+    std::ofstream fs(filename, std::ios::binary);
+    if (!fs.good()) {
+        msg::error("cannot open " + filename + ".");
+        return false;
+    }
+    fs.write((char const *)out.data(), (std::streamsize)out.size());
+    return fs.good();
+}
+
+// Read an object file generated by elf_dump (the objects of the build cache
+// are read back this way by the static linker).
+bool elf_read(std::string const &filename, ObjectFile &obj) {
+    std::ifstream fs(filename, std::ios::binary);
+    std::vector<uint8_t> in((std::istreambuf_iterator<char>(fs)),
+                            std::istreambuf_iterator<char>());
+    auto error = [&](char const *msg) {
+        std::cerr << "error: " << filename << ": " << msg << "." << std::endl;
+        return false;
+    };
+    auto in_bounds = [&](uint64_t offset, uint64_t size) {
+        return offset <= in.size() && size <= in.size() - offset;
+    };
+
+    if (!fs.eof() && !fs.good()) {
+        return error("cannot read the file");
+    }
+    if (in.size() < sizeof(Elf64_Ehdr) || memcmp(in.data(), ELFMAG, SELFMAG) != 0) {
+        return error("not an ELF file");
+    }
+    Elf64_Ehdr header;
+    memcpy(&header, in.data(), sizeof(header));
+    if (header.e_ident[EI_CLASS] != ELFCLASS64 || header.e_type != ET_REL ||
+        header.e_machine != EM_X86_64 || header.e_shentsize != sizeof(Elf64_Shdr) ||
+        !in_bounds(header.e_shoff, header.e_shnum * sizeof(Elf64_Shdr))) {
+        return error("unsupported object file");
+    }
+    std::vector<Elf64_Shdr> sections(header.e_shnum);
+    memcpy(sections.data(), in.data() + header.e_shoff,
+           header.e_shnum * sizeof(Elf64_Shdr));
+    for (auto const &section : sections) {
+        if (section.sh_type != SHT_NOBITS &&
+            !in_bounds(section.sh_offset, section.sh_size)) {
+            return error("invalid section");
+        }
+    }
+    if (header.e_shstrndx >= sections.size()) {
+        return error("invalid section");
+    }
+    auto string_at = [&](Elf64_Shdr const &strtab, uint32_t idx) {
+        if (idx >= strtab.sh_size) {
+            return std::string();
+        }
+        auto str = (char const *)in.data() + strtab.sh_offset + idx;
+        return std::string(str, strnlen(str, strtab.sh_size - idx));
+    };
+    auto const &shstrtab = sections[header.e_shstrndx];
+
+    // sections of the object and their index in the file
+    std::map<size_t, ObjSection> obj_sections;
+    for (size_t i = 0; i < sections.size(); ++i) {
+        auto name = string_at(shstrtab, sections[i].sh_name);
+        auto data = in.data() + sections[i].sh_offset;
+        if (name == ".text") {
+            obj.text.assign(data, data + sections[i].sh_size);
+            obj_sections[i] = ObjSection::Text;
+        } else if (name == ".rodata") {
+            obj.rodata.assign(data, data + sections[i].sh_size);
+            obj_sections[i] = ObjSection::Rodata;
+        }
+    }
+
+    std::vector<std::string> symbols_names;
+    for (auto const &section : sections) {
+        if (section.sh_type != SHT_SYMTAB) {
+            continue;
+        }
+        if (section.sh_link >= sections.size()) {
+            return error("invalid symbol table");
+        }
+        auto const &strtab = sections[section.sh_link];
+        size_t count = section.sh_size / sizeof(Elf64_Sym);
+        for (size_t i = 0; i < count; ++i) {
+            Elf64_Sym sym;
+            memcpy(&sym, in.data() + section.sh_offset + i * sizeof(Elf64_Sym),
+                   sizeof(sym));
+            auto name = string_at(strtab, sym.st_name);
+            symbols_names.push_back(name);
+            if (i == 0 || ELF64_ST_TYPE(sym.st_info) == STT_SECTION) {
+                continue;
+            }
+            ObjSection obj_section = ObjSection::Undefined;
+            if (sym.st_shndx != SHN_UNDEF) {
+                auto it = obj_sections.find(sym.st_shndx);
+                if (it == obj_sections.end()) {
+                    return error("symbol in an unsupported section");
+                }
+                obj_section = it->second;
+            }
+            obj.symbols.push_back(ObjSymbol{
+                name, obj_section, sym.st_value,
+                ELF64_ST_BIND(sym.st_info) != STB_LOCAL});
+        }
+    }
+
+    for (auto const &section : sections) {
+        if (section.sh_type != SHT_RELA) {
+            continue;
+        }
+        auto it = obj_sections.find(section.sh_info);
+        if (it == obj_sections.end() || it->second != ObjSection::Text) {
+            return error("unsupported relocation section");
+        }
+        size_t count = section.sh_size / sizeof(Elf64_Rela);
+        for (size_t i = 0; i < count; ++i) {
+            Elf64_Rela rela;
+            memcpy(&rela, in.data() + section.sh_offset + i * sizeof(Elf64_Rela),
+                   sizeof(rela));
+            size_t sym_idx = ELF64_R_SYM(rela.r_info);
+            if (sym_idx == 0 || sym_idx >= symbols_names.size() ||
+                symbols_names[sym_idx].empty()) {
+                return error("unsupported relocation");
+            }
+            obj.relocations.push_back(ObjRelocation{
+                ObjSection::Text, rela.r_offset, symbols_names[sym_idx],
+                (uint32_t)ELF64_R_TYPE(rela.r_info), rela.r_addend});
+        }
+    }
+    return true;
+}
+
+} // end namespace compiler
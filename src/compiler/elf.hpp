@@ -0,0 +1,47 @@
+#ifndef COMPILER_ELF
+#define COMPILER_ELF
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace compiler {
+
+/*
+ * Architecture independent representation of a relocatable object file. The
+ * encoders fill this structure and the ELF writer dumps it on the disk.
+ */
+
+enum class ObjSection {
+    Undefined, // external symbols
+    Text,
+    Rodata,
+};
+
+struct ObjSymbol {
+    std::string name;
+    ObjSection section;
+    uint64_t offset;
+    bool global;
+};
+
+struct ObjRelocation {
+    ObjSection section; // section in which the relocation is applied
+    uint64_t offset;
+    std::string symbol;
+    uint32_t type; // architecture specific relocation type
+    int64_t addend;
+};
+
+struct ObjectFile {
+    std::vector<uint8_t> text;
+    std::vector<uint8_t> rodata;
+    std::vector<ObjSymbol> symbols;
+    std::vector<ObjRelocation> relocations;
+};
+
+bool elf_dump(ObjectFile const &obj, std::string const &filename);
+bool elf_read(std::string const &filename, ObjectFile &obj);
+
+} // end namespace compiler
+
+#endif
@@ -0,0 +1,172 @@
+#include "linker.hpp"
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+
+namespace compiler {
+
+#define LINK_BASE_ADDRESS 0x400000
+#define LINK_PAGE_SIZE 0x1000
+
+bool static_link_possible(std::vector<ObjectFile> const &objects) {
+    std::set<std::string> defined;
+
+    for (auto const &obj : objects) {
+        for (auto const &sym : obj.symbols) {
+            if (sym.global && sym.section != ObjSection::Undefined) {
+                defined.insert(sym.name);
+            }
+        }
+    }
+    for (auto const &obj : objects) {
+        for (auto const &sym : obj.symbols) {
+            if (sym.section == ObjSection::Undefined && !defined.count(sym.name)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+/*
+ * The executable contains two segments: the headers and the code (read and
+ * execute), then the read only data. The file offsets and the addresses are
+ * the same (modulo the base address), and there is no section header table.
+ */
+bool static_link(std::vector<ObjectFile> const &objects,
+                 std::string const &filename) {
+    size_t headers_size = sizeof(Elf64_Ehdr) + 2 * sizeof(Elf64_Phdr);
+    std::vector<uint8_t> text;
+    std::vector<uint8_t> rodata;
+    std::vector<size_t> text_offsets;
+    std::vector<size_t> rodata_offsets;
+
+    // the code starts after the headers and the data on the next page
+    for (auto const &obj : objects) {
+        text.resize(align_up(headers_size + text.size(), 16) - headers_size);
+        text_offsets.push_back(headers_size + text.size());
+        text.insert(text.end(), obj.text.begin(), obj.text.end());
+    }
+    size_t rodata_start = align_up(headers_size + text.size(), LINK_PAGE_SIZE);
+    for (auto const &obj : objects) {
+        rodata.resize(align_up(rodata.size(), 8));
+        rodata_offsets.push_back(rodata_start + rodata.size());
+        rodata.insert(rodata.end(), obj.rodata.begin(), obj.rodata.end());
+    }
+
+    // symbols addresses (the local symbols are only visible in their object)
+    std::map<std::string, uint64_t> globals;
+    std::vector<std::map<std::string, uint64_t>> locals(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        for (auto const &sym : objects[i].symbols) {
+            uint64_t address = LINK_BASE_ADDRESS + sym.offset;
+            if (sym.section == ObjSection::Undefined) {
+                continue;
+            } else if (sym.section == ObjSection::Text) {
+                address += text_offsets[i];
+            } else {
+                address += rodata_offsets[i];
+            }
+            if (!sym.global) {
+                locals[i][sym.name] = address;
+            } else if (globals.count(sym.name)) {
+                std::cerr << "error: multiple definition of " << sym.name << "."
+                          << std::endl;
+                return false;
+            } else {
+                globals[sym.name] = address;
+            }
+        }
+    }
+    if (!globals.count("_start")) {
+        std::cerr << "error: undefined entry point _start." << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < objects.size(); ++i) {
+        for (auto const &rel : objects[i].relocations) {
+            auto local = locals[i].find(rel.symbol);
+            auto global = globals.find(rel.symbol);
+            if (local == locals[i].end() && global == globals.end()) {
+                std::cerr << "error: undefined reference to " << rel.symbol
+                          << "." << std::endl;
+                return false;
+            }
+            int64_t symbol = (int64_t)(local != locals[i].end() ? local->second
+                                                                : global->second);
+            size_t pos = text_offsets[i] + rel.offset - headers_size;
+            int64_t place = (int64_t)(LINK_BASE_ADDRESS + headers_size + pos);
+
+            // there is no PLT, calls are resolved directly
+            if (rel.type != R_X86_64_PC32 && rel.type != R_X86_64_PLT32) {
+                std::cerr << "error: unsupported relocation type " << rel.type
+                          << "." << std::endl;
+                return false;
+            }
+            int64_t value = symbol + rel.addend - place;
+            if (value < INT32_MIN || value > INT32_MAX || pos + 4 > text.size()) {
+                std::cerr << "error: relocation to " << rel.symbol
+                          << " out of range." << std::endl;
+                return false;
+            }
+            int32_t value32 = (int32_t)value;
+            memcpy(&text[pos], &value32, sizeof(value32));
+        }
+    }
+
+    Elf64_Ehdr header = {};
+    memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = ET_EXEC;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_entry = globals["_start"];
+    header.e_phoff = sizeof(Elf64_Ehdr);
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_phentsize = sizeof(Elf64_Phdr);
+    header.e_phnum = 2;
+
+    Elf64_Phdr segments[2] = {};
+    segments[0].p_type = PT_LOAD;
+    segments[0].p_flags = PF_R | PF_X;
+    segments[0].p_offset = 0;
+    segments[0].p_vaddr = LINK_BASE_ADDRESS;
+    segments[0].p_paddr = LINK_BASE_ADDRESS;
+    segments[0].p_filesz = headers_size + text.size();
+    segments[0].p_memsz = segments[0].p_filesz;
+    segments[0].p_align = LINK_PAGE_SIZE;
+    segments[1].p_type = PT_LOAD;
+    segments[1].p_flags = PF_R;
+    segments[1].p_offset = rodata_start;
+    segments[1].p_vaddr = LINK_BASE_ADDRESS + rodata_start;
+    segments[1].p_paddr = LINK_BASE_ADDRESS + rodata_start;
+    segments[1].p_filesz = rodata.size();
+    segments[1].p_memsz = rodata.size();
+    segments[1].p_align = LINK_PAGE_SIZE;
+
+    std::vector<uint8_t> out(rodata_start + rodata.size(), 0);
+    memcpy(out.data(), &header, sizeof(header));
+    memcpy(out.data() + sizeof(header), segments, sizeof(segments));
+    std::copy(text.begin(), text.end(), out.begin() + (long)headers_size);
+    std::copy(rodata.begin(), rodata.end(), out.begin() + (long)rodata_start);
+
+    std::ofstream fs(filename, std::ios::binary | std::ios::trunc);
+    if (!fs.good()) {
+        std::cerr << "error: cannot open " << filename << "." << std::endl;
+        return false;
+    }
+    fs.write((char const *)out.data(), (std::streamsize)out.size());
+    return fs.good();
+}
+
+} // end namespace compiler
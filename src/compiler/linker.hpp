@@ -0,0 +1,22 @@
+#ifndef COMPILER_LINKER
+#define COMPILER_LINKER
+#include "compiler/elf.hpp"
+#include <string>
+#include <vector>
+
+namespace compiler {
+
+/*
+ * Built-in static linker: the objects are linked into an executable that does
+ * not use the libc nor the dynamic loader (`_start` calls main and exits with a
+ * syscall). This is only possible when all the symbols are defined in the
+ * objects, otherwise (external functions declared with `dcl`) ld is used.
+ */
+
+bool static_link_possible(std::vector<ObjectFile> const &objects);
+bool static_link(std::vector<ObjectFile> const &objects,
+                 std::string const &filename);
+
+} // end namespace compiler
+
+#endif
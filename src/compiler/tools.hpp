@@ -5,42 +5,43 @@
 #include <sstream>
 #include <string>
 #include <iostream>
-#include <type_traits>
 #include <vector>
+#include "tools/process.hpp"
 
 namespace compiler {
 
 size_t get_compiled_string_size(std::string const &str);
 
-template <typename T> std::string ptr_to_string(T *ptr) {
-    std::ostringstream oss;
-    oss << ptr;
-    return oss.str();
-}
-
 std::string base_name(std::string const &filename);
 std::string asm_filename(std::string const &base_name);
 std::string object_filename(std::string const &base_name);
 
-template <typename T>
-std::string format_cmd_arg(T const &arg) {
-    std::ostringstream oss;
+inline void cmd_add_arg(std::vector<std::string> &argv, std::string const &arg) {
+    argv.push_back(arg);
+}
 
-    if constexpr (std::is_same_v<std::vector<std::string>, T>) {
-        for (auto arg_val : arg) {
-            oss << " " << arg_val;
-        }
-    } else {
-        oss << " " << arg;
-    }
-    return oss.str();
+inline void cmd_add_arg(std::vector<std::string> &argv,
+                        std::vector<std::string> const &args) {
+    argv.insert(argv.end(), args.begin(), args.end());
 }
 
+// The command is run without shell (the arguments are not split or
+// interpreted) and its output is reported on std::cerr. Returns the exit
+// status of the command.
 template <typename ...T>
-int run_cmd(std::string const &exec, T ...args) {
-    std::string cmd_str = (exec + ... + format_cmd_arg(args));
-    std::cout << "running: " << cmd_str << std::endl;
-    return system(cmd_str.c_str());
+int run_cmd(std::string const &exec, T const &...args) {
+    std::vector<std::string> argv = {exec};
+    std::string output;
+
+    (cmd_add_arg(argv, args), ...);
+    std::cout << "running:";
+    for (auto const &arg : argv) {
+        std::cout << " " << arg;
+    }
+    std::cout << std::endl;
+    int status = process_run(argv, output);
+    std::cerr << output;
+    return status;
 }
 
 } // end namespace compiler
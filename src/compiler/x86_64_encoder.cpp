@@ -0,0 +1,710 @@
+#include "x86_64_encoder.hpp"
+#include "tools/messages.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <map>
+#include <set>
+
+/*
+ * Minimal x86_64 encoder. It only supports the subset of the instruction set
+ * used by the backend (see x86_64_gnu_linux.cpp), and the operands follow the
+ * GAS intel syntax (noprefix):
+ * - registers: rax, eax, al, xmm0, ...
+ * - immediate values: 42, -1, 0x2a
+ * - memory: [reg], [reg+disp], [reg-disp], [label], or a bare label when the
+ *   instruction is not a branch (label are addressed relatively to rip).
+ */
+
+namespace compiler {
+
+namespace x86_64 {
+
+enum class RegisterKind {
+    Gpr8,
+    Gpr32,
+    Gpr64,
+    Xmm,
+};
+
+struct Register {
+    uint8_t id;
+    RegisterKind kind;
+};
+
+enum class OperandKind {
+    None,
+    Register,
+    Immediate,
+    Memory,
+    Label,
+};
+
+struct Operand {
+    OperandKind kind;
+    Register reg;      // register or base register of a memory operand
+    int64_t value;     // immediate value or memory displacement
+    std::string label; // label or rip relative memory operand
+};
+
+// rel32 field that has to be resolved once all the labels are known
+struct Fixup {
+    size_t position;
+    size_t instruction_end;
+    std::string label;
+    uint32_t relocation_type;
+};
+
+struct EncoderState {
+    std::vector<uint8_t> *text;
+    std::map<std::string, size_t> text_labels;
+    std::map<std::string, size_t> data_labels;
+    std::vector<Fixup> fixups;
+};
+
+/******************************************************************************/
+/*                                  operands                                  */
+/******************************************************************************/
+
+static bool parse_register(std::string const &name, Register &reg) {
+    static char const *gpr64[] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp",
+                                  "rsi", "rdi", "r8",  "r9",  "r10", "r11",
+                                  "r12", "r13", "r14", "r15"};
+    static char const *gpr32[] = {"eax",  "ecx",  "edx",  "ebx",
+                                  "esp",  "ebp",  "esi",  "edi",
+                                  "r8d",  "r9d",  "r10d", "r11d",
+                                  "r12d", "r13d", "r14d", "r15d"};
+    static char const *gpr8[] = {"al",   "cl",   "dl",   "bl",
+                                 "spl",  "bpl",  "sil",  "dil",
+                                 "r8b",  "r9b",  "r10b", "r11b",
+                                 "r12b", "r13b", "r14b", "r15b"};
+
+    for (uint8_t id = 0; id < 16; ++id) {
+        if (name == gpr64[id]) {
+            reg = Register{id, RegisterKind::Gpr64};
+            return true;
+        } else if (name == gpr32[id]) {
+            reg = Register{id, RegisterKind::Gpr32};
+            return true;
+        } else if (name == gpr8[id]) {
+            reg = Register{id, RegisterKind::Gpr8};
+            return true;
+        } else if (name == "xmm" + std::to_string(id)) {
+            reg = Register{id, RegisterKind::Xmm};
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_number(std::string const &str) {
+    size_t start = (str[0] == '-' || str[0] == '+') ? 1 : 0;
+    return str.size() > start && isdigit(str[start]);
+}
+
+static bool parse_number(std::string const &str, int64_t &value) {
+    char *end = nullptr;
+    value = (int64_t)strtoll(str.c_str(), &end, 0);
+    return *end == 0;
+}
+
+static bool parse_memory(std::string const &str, Operand &op) {
+    std::string inner = str.substr(1, str.size() - 2);
+    size_t sign = inner.find_first_of("+-", 1);
+    std::string base = inner.substr(0, sign);
+
+    op.kind = OperandKind::Memory;
+    op.value = 0;
+    if (sign != std::string::npos) {
+        if (!parse_number(inner.substr(sign), op.value)) {
+            return false;
+        }
+    }
+    if (!parse_register(base, op.reg)) {
+        op.label = base;
+    } else if (op.reg.kind != RegisterKind::Gpr64) {
+        return false;
+    }
+    return true;
+}
+
+static bool parse_operand(std::string const &str, Operand &op) {
+    op = Operand{OperandKind::None, {}, 0, ""};
+
+    if (str.empty()) {
+        return true;
+    } else if (str[0] == '[') {
+        return str.back() == ']' && parse_memory(str, op);
+    } else if (parse_register(str, op.reg)) {
+        op.kind = OperandKind::Register;
+    } else if (is_number(str)) {
+        op.kind = OperandKind::Immediate;
+        return parse_number(str, op.value);
+    } else {
+        op.kind = OperandKind::Label;
+        op.label = str;
+    }
+    return true;
+}
+
+// outside of branches, a label designates the memory at this label
+static Operand label_to_memory(Operand const &op) {
+    if (op.kind != OperandKind::Label) {
+        return op;
+    }
+    return Operand{OperandKind::Memory, {}, 0, op.label};
+}
+
+static bool is_reg(Operand const &op, RegisterKind kind) {
+    return op.kind == OperandKind::Register && op.reg.kind == kind;
+}
+
+static bool is_gpr(Operand const &op) {
+    return op.kind == OperandKind::Register && op.reg.kind != RegisterKind::Xmm;
+}
+
+static bool is_rm(Operand const &op) {
+    return is_gpr(op) || op.kind == OperandKind::Memory;
+}
+
+static bool is_xmm_rm(Operand const &op) {
+    return is_reg(op, RegisterKind::Xmm) || op.kind == OperandKind::Memory;
+}
+
+static bool fits_int8(int64_t value) {
+    return value >= -128 && value <= 127;
+}
+
+static bool fits_int32(int64_t value) {
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+// spl, bpl, sil and dil are only accessible with a rex prefix
+static bool requires_rex(Operand const &op) {
+    return is_reg(op, RegisterKind::Gpr8) && op.reg.id >= 4 && op.reg.id < 8;
+}
+
+/******************************************************************************/
+/*                                  emitters                                  */
+/******************************************************************************/
+
+static void emit(EncoderState *state, uint8_t byte) {
+    state->text->push_back(byte);
+}
+
+static void emit32(EncoderState *state, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        emit(state, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+static void emit64(EncoderState *state, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        emit(state, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+static void emit_fixup(EncoderState *state, std::string const &label,
+                       uint32_t relocation_type) {
+    state->fixups.push_back(
+        Fixup{state->text->size(), 0, label, relocation_type});
+    emit32(state, 0);
+}
+
+static void emit_rex(EncoderState *state, bool w, uint8_t reg, uint8_t rm,
+                     bool force) {
+    uint8_t rex = (uint8_t)(0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3));
+    if (rex != 0x40 || force) {
+        emit(state, rex);
+    }
+}
+
+/*
+ * Emit an instruction that uses a ModRM byte:
+ *   [prefix] [rex] opcode modrm [sib] [disp]
+ * `reg` is either a register id or an opcode extension.
+ */
+static void emit_modrm(EncoderState *state, uint8_t prefix,
+                       std::vector<uint8_t> const &opcode, bool w, uint8_t reg,
+                       Operand const &rm, bool force_rex = false) {
+    bool rip_relative = rm.kind == OperandKind::Memory && !rm.label.empty();
+    uint8_t rm_id = rip_relative ? 0 : rm.reg.id;
+
+    if (prefix) {
+        emit(state, prefix);
+    }
+    emit_rex(state, w, reg, rm_id, force_rex || requires_rex(rm));
+    for (uint8_t byte : opcode) {
+        emit(state, byte);
+    }
+
+    uint8_t reg_bits = (uint8_t)((reg & 7) << 3);
+    if (rm.kind == OperandKind::Register) {
+        emit(state, (uint8_t)(0xC0 | reg_bits | (rm_id & 7)));
+    } else if (rip_relative) {
+        emit(state, (uint8_t)(0x05 | reg_bits));
+        emit_fixup(state, rm.label, R_X86_64_PC32);
+    } else {
+        uint8_t base = rm_id & 7;
+        uint8_t mod = 0x80;
+        if (rm.value == 0 && base != 5) { // rbp and r13 require a displacement
+            mod = 0x00;
+        } else if (fits_int8(rm.value)) {
+            mod = 0x40;
+        }
+        emit(state, (uint8_t)(mod | reg_bits | base));
+        if (base == 4) { // rsp and r12 require a sib byte
+            emit(state, 0x24);
+        }
+        if (mod == 0x40) {
+            emit(state, (uint8_t)rm.value);
+        } else if (mod == 0x80) {
+            emit32(state, (uint32_t)rm.value);
+        }
+    }
+}
+
+static void emit_immediate(EncoderState *state, int64_t value, size_t size) {
+    if (size == 1) {
+        emit(state, (uint8_t)value);
+    } else {
+        emit32(state, (uint32_t)value);
+    }
+}
+
+/******************************************************************************/
+/*                                instructions                                */
+/******************************************************************************/
+
+static size_t operand_size(Operand const &op) {
+    if (op.kind != OperandKind::Register) {
+        return 8; // memory operands default to qword (all types are on 8B)
+    }
+    switch (op.reg.kind) {
+    case RegisterKind::Gpr8: return 1;
+    case RegisterKind::Gpr32: return 4;
+    case RegisterKind::Gpr64: return 8;
+    case RegisterKind::Xmm: return 16;
+    }
+    return 8;
+}
+
+static bool encode_mov(EncoderState *state, Operand const &dest,
+                       Operand const &src) {
+    if (is_gpr(dest) && src.kind == OperandKind::Immediate) {
+        uint8_t id = dest.reg.id;
+        switch (dest.reg.kind) {
+        case RegisterKind::Gpr8:
+            emit_rex(state, false, 0, id, requires_rex(dest));
+            emit(state, (uint8_t)(0xB0 + (id & 7)));
+            emit(state, (uint8_t)src.value);
+            break;
+        case RegisterKind::Gpr32:
+            emit_rex(state, false, 0, id, false);
+            emit(state, (uint8_t)(0xB8 + (id & 7)));
+            emit32(state, (uint32_t)src.value);
+            break;
+        default:
+            if (fits_int32(src.value)) {
+                emit_modrm(state, 0, {0xC7}, true, 0, dest);
+                emit32(state, (uint32_t)src.value);
+            } else {
+                emit_rex(state, true, 0, id, false);
+                emit(state, (uint8_t)(0xB8 + (id & 7)));
+                emit64(state, (uint64_t)src.value);
+            }
+            break;
+        }
+    } else if (dest.kind == OperandKind::Memory &&
+               src.kind == OperandKind::Immediate && fits_int32(src.value)) {
+        emit_modrm(state, 0, {0xC7}, true, 0, dest);
+        emit32(state, (uint32_t)src.value);
+    } else if (is_rm(dest) && is_gpr(src)) {
+        size_t size = operand_size(src);
+        emit_modrm(state, 0, {size == 1 ? (uint8_t)0x88 : (uint8_t)0x89},
+                   size == 8, src.reg.id, dest, requires_rex(src));
+    } else if (is_gpr(dest) && src.kind == OperandKind::Memory) {
+        size_t size = operand_size(dest);
+        emit_modrm(state, 0, {size == 1 ? (uint8_t)0x8A : (uint8_t)0x8B},
+                   size == 8, dest.reg.id, src, requires_rex(dest));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * add, or, and, sub, xor and cmp share the same encoding, the extension is
+ * used to select the operation.
+ */
+static bool encode_alu(EncoderState *state, uint8_t ext, Operand const &dest,
+                       Operand const &src) {
+    uint8_t base = (uint8_t)(ext << 3);
+
+    if (is_rm(dest) && src.kind == OperandKind::Immediate) {
+        size_t size = operand_size(dest);
+        if (size == 1) {
+            emit_modrm(state, 0, {0x80}, false, ext, dest);
+            emit_immediate(state, src.value, 1);
+        } else if (fits_int8(src.value)) {
+            emit_modrm(state, 0, {0x83}, size == 8, ext, dest);
+            emit_immediate(state, src.value, 1);
+        } else if (fits_int32(src.value)) {
+            emit_modrm(state, 0, {0x81}, size == 8, ext, dest);
+            emit_immediate(state, src.value, 4);
+        } else {
+            return false;
+        }
+    } else if (is_rm(dest) && is_gpr(src)) {
+        size_t size = operand_size(src);
+        emit_modrm(state, 0, {(uint8_t)(base | (size == 1 ? 0 : 1))}, size == 8,
+                   src.reg.id, dest, requires_rex(src));
+    } else if (is_gpr(dest) && src.kind == OperandKind::Memory) {
+        size_t size = operand_size(dest);
+        emit_modrm(state, 0, {(uint8_t)(base | (size == 1 ? 2 : 3))}, size == 8,
+                   dest.reg.id, src, requires_rex(dest));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool encode_push_pop(EncoderState *state, bool push, Operand const &op) {
+    if (is_reg(op, RegisterKind::Gpr64)) {
+        emit_rex(state, false, 0, op.reg.id, false);
+        emit(state, (uint8_t)((push ? 0x50 : 0x58) + (op.reg.id & 7)));
+    } else if (op.kind == OperandKind::Memory) {
+        if (push) {
+            emit_modrm(state, 0, {0xFF}, false, 6, op);
+        } else {
+            emit_modrm(state, 0, {0x8F}, false, 0, op);
+        }
+    } else if (push && op.kind == OperandKind::Immediate) {
+        if (fits_int8(op.value)) {
+            emit(state, 0x6A);
+            emit_immediate(state, op.value, 1);
+        } else if (fits_int32(op.value)) {
+            emit(state, 0x68);
+            emit_immediate(state, op.value, 4);
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool encode_branch(EncoderState *state, std::vector<uint8_t> const &opcode,
+                          uint8_t ext, Operand const &target,
+                          uint32_t relocation_type) {
+    if (target.kind == OperandKind::Label) {
+        for (uint8_t byte : opcode) {
+            emit(state, byte);
+        }
+        emit_fixup(state, target.label, relocation_type);
+    } else if (ext != 0xFF && (is_reg(target, RegisterKind::Gpr64) ||
+                               target.kind == OperandKind::Memory)) {
+        emit_modrm(state, 0, {0xFF}, false, ext, target);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static int jcc_condition(std::string const &mnemonic) {
+    static const std::map<std::string, int> conditions = {
+        {"jo", 0x0},  {"jno", 0x1}, {"jb", 0x2},  {"jae", 0x3}, {"je", 0x4},
+        {"jz", 0x4},  {"jne", 0x5}, {"jnz", 0x5}, {"jbe", 0x6}, {"ja", 0x7},
+        {"js", 0x8},  {"jns", 0x9}, {"jp", 0xA},  {"jnp", 0xB}, {"jl", 0xC},
+        {"jge", 0xD}, {"jle", 0xE}, {"jg", 0xF},
+    };
+    auto it = conditions.find(mnemonic);
+    return it == conditions.end() ? -1 : it->second;
+}
+
+static int sse_opcode(std::string const &mnemonic) {
+    static const std::map<std::string, int> opcodes = {
+        {"addsd", 0x58}, {"mulsd", 0x59}, {"subsd", 0x5C},
+        {"divsd", 0x5E}, {"sqrtsd", 0x51},
+    };
+    auto it = opcodes.find(mnemonic);
+    return it == opcodes.end() ? -1 : it->second;
+}
+
+static int alu_extension(std::string const &mnemonic) {
+    static const std::map<std::string, int> extensions = {
+        {"add", 0}, {"or", 1}, {"and", 4}, {"sub", 5}, {"xor", 6}, {"cmp", 7},
+    };
+    auto it = extensions.find(mnemonic);
+    return it == extensions.end() ? -1 : it->second;
+}
+
+static bool encode_instruction(EncoderState *state, std::string const &mnemonic,
+                               Operand const &op1, Operand const &op2) {
+    Operand arg1 = label_to_memory(op1);
+    Operand arg2 = label_to_memory(op2);
+    int code = -1;
+
+    if (mnemonic == "mov") {
+        return encode_mov(state, arg1, arg2);
+    } else if ((code = alu_extension(mnemonic)) >= 0) {
+        return encode_alu(state, (uint8_t)code, arg1, arg2);
+    } else if (mnemonic == "push" || mnemonic == "pop") {
+        return encode_push_pop(state, mnemonic == "push", arg1);
+    } else if (mnemonic == "lea") {
+        if (!is_reg(arg1, RegisterKind::Gpr64) ||
+            arg2.kind != OperandKind::Memory) {
+            return false;
+        }
+        emit_modrm(state, 0, {0x8D}, true, arg1.reg.id, arg2);
+    } else if (mnemonic == "imul") {
+        if (!is_gpr(arg1) || !is_rm(arg2) || operand_size(arg1) == 1) {
+            return false;
+        }
+        emit_modrm(state, 0, {0x0F, 0xAF}, operand_size(arg1) == 8,
+                   arg1.reg.id, arg2);
+    } else if (mnemonic == "idiv") {
+        if (!is_rm(arg1) || operand_size(arg1) == 1) {
+            return false;
+        }
+        emit_modrm(state, 0, {0xF7}, operand_size(arg1) == 8, 7, arg1);
+    } else if (mnemonic == "call") {
+        return encode_branch(state, {0xE8}, 2, op1, R_X86_64_PLT32);
+    } else if (mnemonic == "jmp") {
+        return encode_branch(state, {0xE9}, 4, op1, R_X86_64_PC32);
+    } else if ((code = jcc_condition(mnemonic)) >= 0) {
+        return encode_branch(state, {0x0F, (uint8_t)(0x80 | code)}, 0xFF, op1,
+                             R_X86_64_PC32);
+    } else if (mnemonic == "ret") {
+        emit(state, 0xC3);
+    } else if (mnemonic == "syscall") {
+        emit(state, 0x0F);
+        emit(state, 0x05);
+    } else if (mnemonic == "movsd") {
+        if (is_reg(arg1, RegisterKind::Xmm) && is_xmm_rm(arg2)) {
+            emit_modrm(state, 0xF2, {0x0F, 0x10}, false, arg1.reg.id, arg2);
+        } else if (arg1.kind == OperandKind::Memory &&
+                   is_reg(arg2, RegisterKind::Xmm)) {
+            emit_modrm(state, 0xF2, {0x0F, 0x11}, false, arg2.reg.id, arg1);
+        } else {
+            return false;
+        }
+    } else if ((code = sse_opcode(mnemonic)) >= 0) {
+        if (!is_reg(arg1, RegisterKind::Xmm) || !is_xmm_rm(arg2)) {
+            return false;
+        }
+        emit_modrm(state, 0xF2, {0x0F, (uint8_t)code}, false, arg1.reg.id,
+                   arg2);
+    } else if (mnemonic == "cvtsi2sd") {
+        if (!is_reg(arg1, RegisterKind::Xmm) || !is_rm(arg2) ||
+            operand_size(arg2) == 1) {
+            return false;
+        }
+        emit_modrm(state, 0xF2, {0x0F, 0x2A}, operand_size(arg2) == 8,
+                   arg1.reg.id, arg2);
+    } else if (mnemonic == "cvttsd2si") {
+        if (!is_gpr(arg1) || !is_xmm_rm(arg2) || operand_size(arg1) == 1) {
+            return false;
+        }
+        emit_modrm(state, 0xF2, {0x0F, 0x2C}, operand_size(arg1) == 8,
+                   arg1.reg.id, arg2);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************************/
+/*                                    data                                    */
+/******************************************************************************/
+
+// decode the escape sequences of a quoted string (same rules as GAS)
+static bool decode_string(std::string const &str, std::vector<uint8_t> &out) {
+    if (str.size() < 2 || str.front() != '"' || str.back() != '"') {
+        return false;
+    }
+    for (size_t i = 1; i < str.size() - 1; ++i) {
+        if (str[i] != '\\') {
+            out.push_back((uint8_t)str[i]);
+            continue;
+        }
+        char c = str[++i];
+        switch (c) {
+        case 'n': out.push_back('\n'); break;
+        case 't': out.push_back('\t'); break;
+        case 'r': out.push_back('\r'); break;
+        case 'b': out.push_back('\b'); break;
+        case 'f': out.push_back('\f'); break;
+        case 'x': {
+            unsigned value = 0;
+            while (i + 1 < str.size() - 1 && isxdigit(str[i + 1])) {
+                char d = str[++i];
+                value = value * 16 + (unsigned)(isdigit(d) ? d - '0' : (tolower(d) - 'a' + 10));
+            }
+            out.push_back((uint8_t)value);
+        } break;
+        default:
+            if (c >= '0' && c <= '7') {
+                unsigned value = (unsigned)(c - '0');
+                for (int n = 0; n < 2 && str[i + 1] >= '0' && str[i + 1] <= '7'; ++n) {
+                    value = value * 8 + (unsigned)(str[++i] - '0');
+                }
+                out.push_back((uint8_t)value);
+            } else {
+                out.push_back((uint8_t)c); // \\, \" and unknown escapes
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+static bool encode_data(EncoderState *state, Data const &data,
+                        std::vector<uint8_t> &rodata) {
+    if (data.type == ".double") {
+        while (rodata.size() % 8 != 0) {
+            rodata.push_back(0);
+        }
+        state->data_labels[data.label] = rodata.size();
+        double value = strtod(data.value.c_str(), nullptr);
+        uint8_t bytes[sizeof(double)];
+        memcpy(bytes, &value, sizeof(double));
+        rodata.insert(rodata.end(), bytes, bytes + sizeof(double));
+    } else if (data.type == ".string") {
+        state->data_labels[data.label] = rodata.size();
+        if (!decode_string(data.value, rodata)) {
+            return false;
+        }
+        rodata.push_back(0);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************************/
+/*                                   encode                                   */
+/******************************************************************************/
+
+static std::string instruction_to_string(Instruction const &instruction) {
+    std::string str = instruction.instruction;
+    if (!instruction.arg1.empty()) {
+        str += " " + instruction.arg1;
+    }
+    if (!instruction.arg2.empty()) {
+        str += ", " + instruction.arg2;
+    }
+    return str;
+}
+
+static bool resolve_fixups(EncoderState *state, ObjectFile &obj,
+                           std::set<std::string> const &globals) {
+    std::set<std::string> external_symbols;
+
+    for (auto const &fixup : state->fixups) {
+        auto text_label = state->text_labels.find(fixup.label);
+
+        if (text_label != state->text_labels.end()) {
+            int64_t rel = (int64_t)text_label->second - (int64_t)fixup.instruction_end;
+            for (int i = 0; i < 4; ++i) {
+                obj.text[fixup.position + (size_t)i] = (uint8_t)(rel >> (8 * i));
+            }
+            continue;
+        }
+        if (state->data_labels.find(fixup.label) == state->data_labels.end() &&
+            !globals.count(fixup.label)) {
+            external_symbols.insert(fixup.label);
+        }
+        obj.relocations.push_back(ObjRelocation{
+            .section = ObjSection::Text,
+            .offset = fixup.position,
+            .symbol = fixup.label,
+            .type = fixup.relocation_type,
+            .addend = (int64_t)fixup.position - (int64_t)fixup.instruction_end,
+        });
+    }
+    for (auto const &symbol : external_symbols) {
+        obj.symbols.push_back(ObjSymbol{symbol, ObjSection::Undefined, 0, true});
+    }
+    return true;
+}
+
+static bool encode_instructions(EncoderState *state, Asm const &code,
+                                ObjectFile &obj) {
+    for (auto const &instruction : code.instructions) {
+        std::string const &mnemonic = instruction.instruction;
+
+        if (mnemonic.empty() || mnemonic[0] == '#' || mnemonic == ".extern") {
+            continue; // comments, external symbols are found using the fixups
+        }
+        if (mnemonic.back() == ':' && instruction.arg1.empty()) {
+            std::string label = mnemonic.substr(0, mnemonic.size() - 1);
+            if (state->text_labels.count(label) || state->data_labels.count(label)) {
+                msg::error("label " + label + " defined twice.");
+                return false;
+            }
+            state->text_labels[label] = obj.text.size();
+            continue;
+        }
+
+        Operand op1, op2;
+        size_t first_fixup = state->fixups.size();
+        if (!parse_operand(instruction.arg1, op1) ||
+            !parse_operand(instruction.arg2, op2) ||
+            !encode_instruction(state, mnemonic, op1, op2)) {
+            msg::error("cannot encode instruction `" +
+                       instruction_to_string(instruction) + "'.");
+            return false;
+        }
+        for (size_t i = first_fixup; i < state->fixups.size(); ++i) {
+            state->fixups[i].instruction_end = obj.text.size();
+        }
+    }
+    return true;
+}
+
+// the code of the functions is encoded in the order of the program
+bool encode(std::vector<Asm> const &code, ObjectFile &obj) {
+    EncoderState state = {&obj.text, {}, {}, {}};
+    std::set<std::string> globals;
+
+    for (auto const &function_code : code) {
+        globals.insert(function_code.global_symbols.begin(),
+                       function_code.global_symbols.end());
+    }
+    for (auto const &function_code : code) {
+        for (auto const &data : function_code.data) {
+            if (!encode_data(&state, data, obj.rodata)) {
+                msg::error("cannot encode data " + data.label + ": " +
+                           data.type + " " + data.value + ".");
+                return false;
+            }
+        }
+    }
+    for (auto const &function_code : code) {
+        if (!encode_instructions(&state, function_code, obj)) {
+            return false;
+        }
+    }
+
+    for (auto const &label : state.text_labels) {
+        obj.symbols.push_back(ObjSymbol{label.first, ObjSection::Text,
+                                        label.second,
+                                        globals.count(label.first) > 0});
+    }
+    for (auto const &label : state.data_labels) {
+        obj.symbols.push_back(
+            ObjSymbol{label.first, ObjSection::Rodata, label.second, false});
+    }
+    for (auto const &symbol : globals) {
+        if (!state.text_labels.count(symbol)) {
+            obj.symbols.push_back(ObjSymbol{symbol, ObjSection::Undefined, 0, true});
+        }
+    }
+    return resolve_fixups(&state, obj, globals);
+}
+
+} // end namespace x86_64
+
+} // end namespace compiler
@@ -0,0 +1,21 @@
+#ifndef COMPILER_X86_64_ENCODER
+#define COMPILER_X86_64_ENCODER
+#include "compiler/compiler.hpp"
+#include "compiler/elf.hpp"
+
+namespace compiler {
+
+namespace x86_64 {
+
+/*
+ * Encode the instructions and the data generated by the backend into machine
+ * code. This replaces the GNU assembler (the instructions use the same intel
+ * syntax as the one used in the assembly dump).
+ */
+bool encode(std::vector<Asm> const &code, ObjectFile &obj);
+
+} // end namespace x86_64
+
+} // end namespace compiler
+
+#endif
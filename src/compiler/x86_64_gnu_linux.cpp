@@ -2,12 +2,13 @@
 #include "compiler/compiler.hpp"
 #include "compiler/tools.hpp"
 #include "scope.hpp"
+#include "tools/parallel.hpp"
+#include "tools/messages.hpp"
 #include "tools/string.hpp"
 #include "../type.hpp"
 #include <array>
 #include <cassert>
 #include <cstring>
-#include <iostream>
 
 /*
  * Conventions:
@@ -51,8 +52,8 @@ void mov_result_to_register(CompilerState *state, std::string const &register_na
     asm_mov(state, register_name, asm_addr(state->last_expr_addr));
 }
 
-Address create_tmp_str_value(CompilerState *state, Ast *value, Address addr) {
-    std::string value_str(value->data.value.value.string.ptr);
+Address create_tmp_str_value(CompilerState *state, AstId value, Address addr) {
+    std::string value_str(ast_get<Value>(state->asts, value).value.string.ptr);
     Address result_addr;
 
     result_addr.addressing_mode = AddressingMode::Register;
@@ -69,16 +70,16 @@ Address create_tmp_str_value(CompilerState *state, Ast *value, Address addr) {
     return result_addr;
 }
 
-void compile_block(CompilerState *state, Ast *ast, Scope *scope);
+void compile_block(CompilerState *state, AstId ast);
 
-void compile_ast(CompilerState *state, Ast *ast, Scope *scope);
+void compile_ast(CompilerState *state, AstId ast);
 
 /*
  * When this function is called, rax will always contain the value
  */
-void compile_value(CompilerState *state, Ast *ast, Scope *scope) {
-    Value *value_ast = &ast->data.value;
-    Type *type = scope->expr_types[ast];
+void compile_value(CompilerState *state, AstId ast) {
+    Value const *value_ast = &ast_get<Value>(state->asts, ast);
+    Type *type = get_expr_type(state, ast);
 
     switch (value_ast->kind) {
     case ValueKind::Character:
@@ -90,43 +91,43 @@ void compile_value(CompilerState *state, Ast *ast, Scope *scope) {
         asm_addr_register(state, "rax", type);
         break;
     case ValueKind::Real: {
-        auto flt_id = asm_create_data_id(state->code, "flt");
+        auto flt_id = asm_create_data_id(state, "flt");
         asm_add_data(state->code, flt_id, ".double",
                      std::to_string(value_ast->value.real));
         asm_mov(state, "xmm0", flt_id);
         asm_addr_register(state, "xmm0", type);
     } break;
     case ValueKind::String: {
-        std::string label = asm_create_data_id(state->code, "value_");
+        std::string label = asm_create_data_id(state, "value_");
         asm_add_data(state->code, label, ".string", value_ast->value.string.ptr);
         asm_addr_immediate_value(state, label, type);
     } break;
     }
 }
 
-void compile_variable_definition(CompilerState *state, Ast *ast, Scope *scope) {
-    VariableDefinition *var_ast = &ast->data.variable_definition;
-    auto type = scope_lookup_symbol(scope, var_ast->name.ptr)->type;
+void compile_variable_definition(CompilerState *state, AstId ast) {
+    VariableDefinition const *var_ast = &ast_get<VariableDefinition>(state->asts, ast);
+    auto type = (*state->symbols)[var_ast->symbol].type;
     auto size = size_of(type);
 
     size += size % 16; // ensure alignment
-    allocate_stack_variable(state, var_ast->name.ptr, size, type, "rbp");
+    allocate_stack_variable(state, var_ast->symbol, size, type, "rbp");
     asm_add_instruction(state->code, "sub", "rsp", std::to_string(size));
     asm_comment_last_instruction(state->code, var_ast->name.ptr);
 }
 
-void compile_assignment(CompilerState *state, Ast *ast, Scope *scope) {
-    Assignment *assignment_ast = &ast->data.assignment;
+void compile_assignment(CompilerState *state, AstId ast) {
+    Assignment const *assignment_ast = &ast_get<Assignment>(state->asts, ast);
     Address target;
-    auto target_type = scope->expr_types[assignment_ast->target];
-    auto value_type = scope->expr_types[assignment_ast->value];
+    auto target_type = get_expr_type(state, assignment_ast->target);
+    auto value_type = get_expr_type(state, assignment_ast->value);
 
-    compile_ast(state, assignment_ast->target, scope);
+    compile_ast(state, assignment_ast->target);
     target = state->last_expr_addr;
 
     if (target.addressing_mode == AddressingMode::RegisterIndirect) {
         asm_add_instruction(state->code, "push", target.register_name);
-        compile_ast(state, assignment_ast->value, scope);
+        compile_ast(state, assignment_ast->value);
         asm_add_instruction(state->code, "pop", "rdx");
         if (is_flt(target_type)) {
             std::string value_addr = asm_addr(state->last_expr_addr);
@@ -145,7 +146,7 @@ void compile_assignment(CompilerState *state, Ast *ast, Scope *scope) {
                                    type_to_string(target_type));
         }
     } else if (target.addressing_mode == AddressingMode::Based) {
-        compile_ast(state, assignment_ast->value, scope);
+        compile_ast(state, assignment_ast->value);
         if (is_flt(target_type)) {
             auto value_addr = asm_addr(state->last_expr_addr);
             if (!is_flt(value_type)) {
@@ -159,10 +160,10 @@ void compile_assignment(CompilerState *state, Ast *ast, Scope *scope) {
             // str is store backward as followed on the stack:
             // [nb bytes] <- effective address of the string
             // [data ptr]
-            if (assignment_ast->value->kind == AstKind::Value) {
+            if (ast_kind(state->asts, assignment_ast->value) == AstKind::Value) {
                 auto value_addr = state->last_expr_addr;
                 std::string value_str(
-                    assignment_ast->value->data.value.value.string.ptr);
+                    ast_get<Value>(state->asts, assignment_ast->value).value.string.ptr);
                 // nb bytes
                 asm_mov(state, "rdx", std::to_string(value_str.size()));
                 asm_mov(state, asm_addr(target), "rdx");
@@ -195,18 +196,18 @@ void compile_assignment(CompilerState *state, Ast *ast, Scope *scope) {
                                    type_to_string(target_type));
         }
     } else {
-        std::cerr << "error: invalide target." << std::endl;
+        msg::error("invalide target.");
     }
 }
 
-void compile_index_expression(CompilerState *state, Ast *ast, Scope *scope) {
-    IndexExpression *expr_ast = &ast->data.index_expression;
-    auto type = scope->expr_types[ast];
+void compile_index_expression(CompilerState *state, AstId ast) {
+    IndexExpression const *expr_ast = &ast_get<IndexExpression>(state->asts, ast);
+    auto type = get_expr_type(state, ast);
 
     // TODO: make sure that this works with float arrays
-    compile_ast(state, expr_ast->element, scope);
+    compile_ast(state, expr_ast->element);
     auto element_addr = state->last_expr_addr;
-    compile_ast(state, expr_ast->index, scope);
+    compile_ast(state, expr_ast->index);
     auto index_result_addr = state->last_expr_addr;
     asm_add_instruction(state->code, "mov", "rdi", asm_addr(index_result_addr));
     asm_add_instruction(state->code, "lea", "rax", asm_addr(element_addr));
@@ -214,18 +215,18 @@ void compile_index_expression(CompilerState *state, Ast *ast, Scope *scope) {
     asm_addr_register_indirect(state, "rax", type);
 }
 
-void compile_variable_reference(CompilerState *state, Ast *ast, Scope *) {
-    VariableReference *var_ref_ast = &ast->data.variable_reference;
+void compile_variable_reference(CompilerState *state, AstId ast) {
+    VariableReference const *var_ref_ast = &ast_get<VariableReference>(state->asts, ast);
     // TODO: the addressing mode might not be based all the time
-    auto addr = get_address(state, var_ref_ast->name.ptr);
+    auto addr = get_address(state, var_ref_ast->symbol);
     asm_addr_based(state, "rbp", addr.offset, addr.type);
 }
 
-void compile_add_sub_int(CompilerState *state, ArithmeticOperation *ast,
-                         Scope *scope, bool sub, Type *type) {
-    compile_ast(state, ast->rhs, scope);
+void compile_add_sub_int(CompilerState *state, ArithmeticOperation const *ast,
+                         bool sub, Type *type) {
+    compile_ast(state, ast->rhs);
     asm_add_instruction(state->code, "push", asm_addr(state->last_expr_addr));
-    compile_ast(state, ast->lhs, scope);
+    compile_ast(state, ast->lhs);
     mov_result_to_register(state, "rax");
     asm_add_instruction(state->code, "pop", "rdx");
     if (sub) {
@@ -236,11 +237,11 @@ void compile_add_sub_int(CompilerState *state, ArithmeticOperation *ast,
     asm_addr_register(state, "rax", type);
 }
 
-void compile_mul_int(CompilerState *state, ArithmeticOperation *ast, Scope *scope,
+void compile_mul_int(CompilerState *state, ArithmeticOperation const *ast,
                      Type *type) {
-    compile_ast(state, ast->rhs, scope);
+    compile_ast(state, ast->rhs);
     asm_add_instruction(state->code, "push", asm_addr(state->last_expr_addr));
-    compile_ast(state, ast->lhs, scope);
+    compile_ast(state, ast->lhs);
     asm_add_instruction(state->code, "pop", "rdx");
     // note: in 64 bits mode imul's 2 operands should be 32 bits long, and
     // the result is 64 bits.
@@ -249,11 +250,11 @@ void compile_mul_int(CompilerState *state, ArithmeticOperation *ast, Scope *scop
     asm_addr_register(state, "rax", type);
 }
 
-void compile_div_int(CompilerState *state, ArithmeticOperation *ast, Scope *scope,
+void compile_div_int(CompilerState *state, ArithmeticOperation const *ast,
                      Type *type) {
-    compile_ast(state, ast->rhs, scope);
+    compile_ast(state, ast->rhs);
     asm_add_instruction(state->code, "push", asm_addr(state->last_expr_addr));
-    compile_ast(state, ast->lhs, scope);
+    compile_ast(state, ast->lhs);
     asm_add_instruction(state->code, "pop", "rdi");
     mov_result_to_register(state, "rax");
     asm_add_instruction(state->code, "xor", "rdx", "rdx"); // zero rdx
@@ -262,21 +263,21 @@ void compile_div_int(CompilerState *state, ArithmeticOperation *ast, Scope *scop
 }
 
 void compile_arithmetic_operation_flt(CompilerState *state,
-                                      ArithmeticOperation *ast,
-                                      Scope *scope, std::string const &op,
+                                      ArithmeticOperation const *ast,
+                                      std::string const &op,
                                       Type *type) {
-    compile_ast(state, ast->rhs, scope);
+    compile_ast(state, ast->rhs);
     asm_add_instruction(state->code, "sub", "rsp", "16");
     // implicit convertion to double
-    if (is_flt(scope->expr_types[ast->rhs])) {
+    if (is_flt(get_expr_type(state, ast->rhs))) {
         asm_mov(state, "xmm0", asm_addr(state->last_expr_addr));
         asm_mov(state, "[rsp]", "xmm0");
     } else {
         asm_add_instruction(state->code, "cvtsi2sd", "xmm0", asm_addr(state->last_expr_addr));
         asm_mov(state, "[rsp]", "xmm0");
     }
-    compile_ast(state, ast->lhs, scope);
-    if (is_flt(scope->expr_types[ast->lhs])) {
+    compile_ast(state, ast->lhs);
+    if (is_flt(get_expr_type(state, ast->lhs))) {
         mov_result_to_register(state, "xmm0");
     } else {
         asm_add_instruction(state->code, "cvtsi2sd", "xmm0", asm_addr(state->last_expr_addr));
@@ -287,59 +288,59 @@ void compile_arithmetic_operation_flt(CompilerState *state,
     asm_add_instruction(state->code, "add", "rsp", "16");
 }
 
-void compile_arithmetic_operation(CompilerState *state, Ast *ast, Scope *scope) {
-    ArithmeticOperation *op_ast = &ast->data.arithmetic_operation;
-    Type *op_type = scope->expr_types[ast];
+void compile_arithmetic_operation(CompilerState *state, AstId ast) {
+    ArithmeticOperation const *op_ast = &ast_get<ArithmeticOperation>(state->asts, ast);
+    Type *op_type = get_expr_type(state, ast);
     switch (op_ast->kind) {
     case ArithmeticOperationKind::Add:
-        if (is_flt(scope_lookup_expr_type(scope, ast))) {
-            compile_arithmetic_operation_flt(state, op_ast, scope, "addsd",
+        if (is_flt(get_expr_type(state, ast))) {
+            compile_arithmetic_operation_flt(state, op_ast, "addsd",
                                              op_type);
         } else {
-            compile_add_sub_int(state, op_ast, scope, false, op_type);
+            compile_add_sub_int(state, op_ast, false, op_type);
         }
         break;
     case ArithmeticOperationKind::Sub:
-        if (is_flt(scope_lookup_expr_type(scope, ast))) {
-            compile_arithmetic_operation_flt(state, op_ast, scope, "subsd",
+        if (is_flt(get_expr_type(state, ast))) {
+            compile_arithmetic_operation_flt(state, op_ast, "subsd",
                                              op_type);
         } else {
-            compile_add_sub_int(state, op_ast, scope, true, op_type);
+            compile_add_sub_int(state, op_ast, true, op_type);
         }
         break;
     case ArithmeticOperationKind::Mul:
-        if (is_flt(scope_lookup_expr_type(scope, ast))) {
-            compile_arithmetic_operation_flt(state, op_ast, scope, "mulsd",
+        if (is_flt(get_expr_type(state, ast))) {
+            compile_arithmetic_operation_flt(state, op_ast, "mulsd",
                                              op_type);
         } else {
-            compile_mul_int(state, op_ast, scope, op_type);
+            compile_mul_int(state, op_ast, op_type);
         }
         break;
     case ArithmeticOperationKind::Div:
-        if (is_flt(scope_lookup_expr_type(scope, ast))) {
-            compile_arithmetic_operation_flt(state, op_ast, scope, "divsd",
+        if (is_flt(get_expr_type(state, ast))) {
+            compile_arithmetic_operation_flt(state, op_ast, "divsd",
                                              op_type);
         } else {
-            compile_div_int(state, op_ast, scope, op_type);
+            compile_div_int(state, op_ast, op_type);
         }
         break;
     }
 }
 
-#define LABEL(ast, suffix) "label_" + ptr_to_string(ast) + suffix
+#define LABEL(ast, suffix) "label_" + asm_label_id(state, ast) + suffix
 #define TRUE_LABEL(ast) LABEL(ast, "_true")
 #define FALSE_LABEL(ast) LABEL(ast, "_false")
 #define BEGIN_LABEL(ast) LABEL(ast, "_begin")
 #define END_LABEL(ast) LABEL(ast, "_end")
 
-void compile_cmp(CompilerState *state, Ast *ast, Scope *scope, std::string const &jmp) {
-    Ast *lhs = ast->data.boolean_operation.lhs;
-    Ast *rhs = ast->data.boolean_operation.rhs;
+void compile_cmp(CompilerState *state, AstId ast, std::string const &jmp) {
+    AstId lhs = ast_get<BooleanOperation>(state->asts, ast).lhs;
+    AstId rhs = ast_get<BooleanOperation>(state->asts, ast).rhs;
 
-    compile_ast(state, lhs, scope);
+    compile_ast(state, lhs);
     mov_result_to_register(state, "rax");
     asm_add_instruction(state->code, "push", "rax");
-    compile_ast(state, rhs, scope);
+    compile_ast(state, rhs);
     mov_result_to_register(state, "rax");
     asm_add_instruction(state->code, "pop", "rdx");
     asm_add_instruction(state->code, "cmp", "rdx", "rax");
@@ -347,14 +348,14 @@ void compile_cmp(CompilerState *state, Ast *ast, Scope *scope, std::string const
     asm_add_instruction(state->code, "jmp", FALSE_LABEL(ast));
 }
 
-void compile_boolean_operation(CompilerState *state, Ast *ast, Scope *scope) {
+void compile_boolean_operation(CompilerState *state, AstId ast) {
     // TODO: float?
-    BooleanOperation *op_ast = &ast->data.boolean_operation;
+    BooleanOperation const *op_ast = &ast_get<BooleanOperation>(state->asts, ast);
     switch (op_ast->kind) {
     case BooleanOperationKind::And:
-        compile_ast(state, op_ast->lhs, scope);
+        compile_ast(state, op_ast->lhs);
         asm_add_label(state->code, TRUE_LABEL(op_ast->lhs));
-        compile_ast(state, op_ast->rhs, scope);
+        compile_ast(state, op_ast->rhs);
         asm_add_label(state->code, TRUE_LABEL(op_ast->rhs));
         asm_add_instruction(state->code, "jmp", TRUE_LABEL(ast));
         asm_add_label(state->code, FALSE_LABEL(op_ast->lhs));
@@ -362,9 +363,9 @@ void compile_boolean_operation(CompilerState *state, Ast *ast, Scope *scope) {
         asm_add_instruction(state->code, "jmp", FALSE_LABEL(ast));
         break;
     case BooleanOperationKind::Lor:
-        compile_ast(state, op_ast->lhs, scope);
+        compile_ast(state, op_ast->lhs);
         asm_add_label(state->code, FALSE_LABEL(op_ast->lhs));
-        compile_ast(state, op_ast->rhs, scope);
+        compile_ast(state, op_ast->rhs);
         asm_add_label(state->code, FALSE_LABEL(op_ast->rhs));
         asm_add_instruction(state->code, "jmp", FALSE_LABEL(ast));
         asm_add_label(state->code, TRUE_LABEL(op_ast->lhs));
@@ -373,7 +374,7 @@ void compile_boolean_operation(CompilerState *state, Ast *ast, Scope *scope) {
         break;
     case BooleanOperationKind::Xor:
         // evaluate lhs
-        compile_ast(state, op_ast->lhs, scope);
+        compile_ast(state, op_ast->lhs);
         asm_add_label(state->code, TRUE_LABEL(op_ast->lhs));
         asm_add_instruction(state->code, "push", "1");
         asm_add_instruction(state->code, "jmp", LABEL(ast, "_rhs"));
@@ -381,7 +382,7 @@ void compile_boolean_operation(CompilerState *state, Ast *ast, Scope *scope) {
         asm_add_instruction(state->code, "push", "0");
         // evaluate rhs
         asm_add_label(state->code, LABEL(ast, "_rhs"));
-        compile_ast(state, op_ast->rhs, scope);
+        compile_ast(state, op_ast->rhs);
         asm_add_label(state->code, TRUE_LABEL(op_ast->rhs));
         asm_add_instruction(state->code, "mov", "rax", "1");
         asm_add_instruction(state->code, "jmp", LABEL(ast, "_xor"));
@@ -395,7 +396,7 @@ void compile_boolean_operation(CompilerState *state, Ast *ast, Scope *scope) {
         asm_add_instruction(state->code, "jmp", FALSE_LABEL(ast));
         break;
     case BooleanOperationKind::Not:
-        compile_ast(state, op_ast->lhs, scope);
+        compile_ast(state, op_ast->lhs);
         asm_add_label(state->code, FALSE_LABEL(op_ast->lhs));
         asm_add_instruction(state->code, "jmp", TRUE_LABEL(ast));
         asm_add_label(state->code, TRUE_LABEL(op_ast->lhs));
@@ -403,31 +404,31 @@ void compile_boolean_operation(CompilerState *state, Ast *ast, Scope *scope) {
         break;
         // TODO: be carefull with unsigned in the future
     case BooleanOperationKind::Eql:
-        compile_cmp(state, ast, scope, "je");
+        compile_cmp(state, ast, "je");
         break;
     case BooleanOperationKind::Inf:
-        compile_cmp(state, ast, scope, "jl");
+        compile_cmp(state, ast, "jl");
         break;
     case BooleanOperationKind::Sup:
-        compile_cmp(state, ast, scope, "jg");
+        compile_cmp(state, ast, "jg");
         break;
     case BooleanOperationKind::Ieq:
-        compile_cmp(state, ast, scope, "jle");
+        compile_cmp(state, ast, "jle");
         break;
     case BooleanOperationKind::Seq:
-        compile_cmp(state, ast, scope, "jge");
+        compile_cmp(state, ast, "jge");
         break;
     }
 }
 
 // TODO: builtin function should not be compiled but linked !
-void compile_builtin_function(CompilerState *state, Ast *ast, Scope *) {
-    BuiltinFunction *fun_ast = &ast->data.builtin_function;
+void compile_builtin_function(CompilerState *state, AstId ast) {
+    BuiltinFunction const *fun_ast = &ast_get<BuiltinFunction>(state->asts, ast);
     switch (fun_ast->kind) {
     case BuiltinFunctionKind::Shw: {
         // TODO: for now we only support text
-        std::string msg_id = asm_create_data_id(state->code, "shw_msg");
-        std::string msg = fun_ast->argument->data.value.value.string.ptr;
+        std::string msg_id = asm_create_data_id(state, "shw_msg");
+        std::string msg = ast_get<Value>(state->asts, fun_ast->argument).value.string.ptr;
         std::string msg_len = std::to_string(get_compiled_string_size(msg));
 
         asm_add_data(state->code, msg_id, ".string", msg);
@@ -444,14 +445,14 @@ void compile_builtin_function(CompilerState *state, Ast *ast, Scope *) {
     }
 }
 
-void compile_function_call(CompilerState *state, Ast *ast, Scope *scope) {
+void compile_function_call(CompilerState *state, AstId ast) {
     // WARN: make sure to put the number of float arguments in `al` before
     // calling C variadic functions
     // TODO: implement a system that avoid pushing arguments on the stack
     // [arg_{N}, arg_{N - 1}, arg_{N - 2}, ret_addr, rbp]
     Type *function_type =
-        scope_lookup_symbol(scope, ast->data.function_call.name.ptr)->type;
-    auto args = ast->data.function_call.arguments;
+        (*state->symbols)[ast_get<FunctionCall>(state->asts, ast).symbol].type;
+    auto args = ast_get<FunctionCall>(state->asts, ast).arguments;
     auto args_type = function_type->data.function.arguments_types;
     size_t int_idx = 0, flt_idx = 0;
     size_t stack_size_to_release = 0;
@@ -459,7 +460,7 @@ void compile_function_call(CompilerState *state, Ast *ast, Scope *scope) {
     // TODO: check the rules for structs
     for (size_t i = 0; i < args.len; i++) {
         // compile the argument ast
-        compile_ast(state, args[i], scope);
+        compile_ast(state, args[i]);
         auto value_addr = state->last_expr_addr;
 
         if (is_flt(args_type[i])) {
@@ -513,7 +514,7 @@ void compile_function_call(CompilerState *state, Ast *ast, Scope *scope) {
     }
     // call the function
     asm_add_instruction(state->code, "xor", "rax", "rax");
-    asm_add_instruction(state->code, "call", ast->data.function_call.name.ptr);
+    asm_add_instruction(state->code, "call", ast_get<FunctionCall>(state->asts, ast).name.ptr);
     // make sure the compiler know that the result will be store in rax (if
     // the function returns a result).
     if (is_flt(function_type->data.function.return_type)) {
@@ -526,59 +527,53 @@ void compile_function_call(CompilerState *state, Ast *ast, Scope *scope) {
     }
 }
 
-void compile_cnd_stmt(CompilerState *state, Ast *ast, Scope *scope) {
-    assert(map_contains(scope->child_scopes, ast));
-    CndStmt *stmt = &ast->data.cnd_stmt;
-    Scope *cnd_scope = scope->child_scopes[ast];
+void compile_cnd_stmt(CompilerState *state, AstId ast) {
+    CndStmt const *stmt = &ast_get<CndStmt>(state->asts, ast);
 
-    compile_ast(state, stmt->condition, cnd_scope);
+    compile_ast(state, stmt->condition);
     asm_add_label(state->code, TRUE_LABEL(stmt->condition));
-    compile_block(state, stmt->block, cnd_scope);
-    asm_add_instruction(state->code, "jmp", END_LABEL(stmt));
+    compile_block(state, stmt->block);
+    asm_add_instruction(state->code, "jmp", END_LABEL(ast));
     asm_add_label(state->code, FALSE_LABEL(stmt->condition));
-    if (stmt->otw) {
+    if (stmt->otw != AST_NULL) {
         // TODO: check that nested conditions are compiled correctly
-        compile_ast(state, stmt->otw, scope);
+        compile_ast(state, stmt->otw);
     }
-    asm_add_label(state->code, END_LABEL(stmt));
+    asm_add_label(state->code, END_LABEL(ast));
 }
 
-void compile_for_stmt(CompilerState *state, Ast *ast, Scope *scope) {
-    assert(map_contains(scope->child_scopes, ast));
-    ForStmt *stmt = &ast->data.for_stmt;
-    Ast *cnd = stmt->condition;
-    Scope *for_scope = scope->child_scopes[ast];
+void compile_for_stmt(CompilerState *state, AstId ast) {
+    ForStmt const *stmt = &ast_get<ForStmt>(state->asts, ast);
+    AstId cnd = stmt->condition;
 
-    compile_ast(state, stmt->init, for_scope);
-    asm_add_label(state->code, BEGIN_LABEL(stmt));
-    compile_ast(state, stmt->condition, for_scope);
+    compile_ast(state, stmt->init);
+    asm_add_label(state->code, BEGIN_LABEL(ast));
+    compile_ast(state, stmt->condition);
     asm_add_label(state->code, TRUE_LABEL(cnd));
-    compile_block(state, stmt->block, for_scope);
-    compile_ast(state, stmt->step, for_scope);
-    asm_add_instruction(state->code, "jmp", BEGIN_LABEL(stmt));
+    compile_block(state, stmt->block);
+    compile_ast(state, stmt->step);
+    asm_add_instruction(state->code, "jmp", BEGIN_LABEL(ast));
     asm_add_label(state->code, FALSE_LABEL(cnd));
 }
 
-void compile_whl_stmt(CompilerState *state, Ast *ast, Scope *scope) {
-    assert(map_contains(scope->child_scopes, ast));
-    WhlStmt *stmt = &ast->data.whl_stmt;
-    Ast *cnd = stmt->condition;
-    Scope *whl_scope = scope->child_scopes[ast];
+void compile_whl_stmt(CompilerState *state, AstId ast) {
+    WhlStmt const *stmt = &ast_get<WhlStmt>(state->asts, ast);
+    AstId cnd = stmt->condition;
 
-    asm_add_label(state->code, BEGIN_LABEL(stmt));
-    compile_ast(state, stmt->condition, whl_scope);
+    asm_add_label(state->code, BEGIN_LABEL(ast));
+    compile_ast(state, stmt->condition);
     asm_add_label(state->code, TRUE_LABEL(cnd));
-    compile_block(state, stmt->block, whl_scope);
-    asm_add_instruction(state->code, "jmp", BEGIN_LABEL(stmt));
+    compile_block(state, stmt->block);
+    asm_add_instruction(state->code, "jmp", BEGIN_LABEL(ast));
     asm_add_label(state->code, FALSE_LABEL(cnd));
 }
 
-void compile_ret_stmt(CompilerState *state, Ast *ast, Scope *scope) {
-    RetStmt *ret_ast = &ast->data.ret_stmt;
+void compile_ret_stmt(CompilerState *state, AstId ast) {
+    RetStmt const *ret_ast = &ast_get<RetStmt>(state->asts, ast);
 
-    compile_ast(state, ret_ast->expression, scope);
-    if (ret_ast->expression->kind != AstKind::Value) {
-        if (is_flt(scope_lookup_expr_type(scope, ret_ast->expression))) {
+    compile_ast(state, ret_ast->expression);
+    if (ast_kind(state->asts, ret_ast->expression) != AstKind::Value) {
+        if (is_flt(get_expr_type(state, ret_ast->expression))) {
             asm_mov(state, "xmm0", asm_addr(state->last_expr_addr));
         } else {
             asm_mov(state, "rax", asm_addr(state->last_expr_addr));
@@ -586,23 +581,23 @@ void compile_ret_stmt(CompilerState *state, Ast *ast, Scope *scope) {
     }
     // TODO: this is not required if the return is at the end of the block
     asm_add_instruction(state->code, "jmp",
-                        "epilogue_" + std::string(state->curr_function->data.function.name.ptr));
+                        "epilogue_" + std::string(ast_get<Function>(state->asts, state->curr_function).name.ptr));
 }
 
-void compile_block(CompilerState *state, Ast *ast, Scope *scope) {
-    Block *block_ast = &ast->data.block;
+void compile_block(CompilerState *state, AstId ast) {
+    Block const *block_ast = &ast_get<Block>(state->asts, ast);
     for (auto instruction : block_ast->asts) {
-        compile_ast(state, instruction, scope->child_scopes[ast]);
+        compile_ast(state, instruction);
         // TODO: free the memory allocated on the stack in this block (unless this is a function block)
     }
 }
 
-void allocate_arguments(CompilerState *state, Ast *ast, Scope *scope) {
-    auto args = ast->data.function.arguments;
+void allocate_arguments(CompilerState *state, AstId ast) {
+    auto args = ast_get<Function>(state->asts, ast).arguments;
     size_t int_idx = 0, flt_idx = 0;
     for (size_t idx = 0; idx < args.len; idx++) {
-        auto *var_ast = &args[idx]->data.variable_definition;
-        auto type = scope_lookup_symbol(scope, var_ast->name.ptr)->type;
+        auto *var_ast = &ast_get<VariableDefinition>(state->asts, args[idx]);
+        auto type = (*state->symbols)[var_ast->symbol].type;
         std::string reg = "";
 
         if (is_int(type) || is_chr(type)) {
@@ -628,29 +623,28 @@ void allocate_arguments(CompilerState *state, Ast *ast, Scope *scope) {
             }
             flt_idx++;
         } else {
-            std::cerr << "error: not implemented" << std::endl;
+            msg::error("not implemented.");
         }
-        compile_variable_definition(state, args[idx], scope);
-        asm_mov(state, asm_addr(get_address(state, var_ast->name.ptr)), reg);
+        compile_variable_definition(state, args[idx]);
+        asm_mov(state, asm_addr(get_address(state, var_ast->symbol)), reg);
     }
 }
 
-void compile_function_definition(CompilerState *state, Ast *ast, Scope *scope) {
-    assert(map_contains(scope->child_scopes, ast));
-    Function *fund_def_ast = &ast->data.function;
-    Scope *function_scope = scope->child_scopes[ast];
+void compile_function_definition(CompilerState *state, AstId ast) {
+    Function const *fund_def_ast = &ast_get<Function>(state->asts, ast);
     state->curr_function = ast;
     state->frame_offset = 8;
 
+    // functions are global so they can be called from other units
+    asm_add_global_symbol(state->code, fund_def_ast->name.ptr);
     asm_add_label(state->code, fund_def_ast->name.ptr);
     asm_add_instruction(state->code, "push", "rbp");
     asm_add_instruction(state->code, "mov", "rbp", "rsp");
 
     // TODO: optimize this
-    allocate_arguments(state, ast, function_scope);
+    allocate_arguments(state, ast);
 
-    // TODO: we want to go down the scope
-    compile_block(state, fund_def_ast->body, function_scope);
+    compile_block(state, fund_def_ast->body);
 
     asm_add_label(state->code, "epilogue_" + std::string(fund_def_ast->name.ptr));
     asm_add_instruction(state->code, "mov", "rsp", "rbp");
@@ -658,60 +652,60 @@ void compile_function_definition(CompilerState *state, Ast *ast, Scope *scope) {
     asm_add_instruction(state->code, "ret");
 }
 
-void compile_function_declaration(CompilerState *state, Ast *ast, Scope *) {
-    asm_add_instruction(state->code, ".extern", ast->data.function.name.ptr);
+void compile_function_declaration(CompilerState *state, AstId ast) {
+    asm_add_instruction(state->code, ".extern", ast_get<Function>(state->asts, ast).name.ptr);
 }
 
-void compile_ast(CompilerState *state, Ast *ast, Scope *scope) {
-    switch (ast->kind) {
+void compile_ast(CompilerState *state, AstId ast) {
+    switch (ast_kind(state->asts, ast)) {
     case AstKind::Value:
-        compile_value(state, ast, scope);
+        compile_value(state, ast);
         break;
     case AstKind::VariableDefinition:
-        compile_variable_definition(state, ast, scope);
+        compile_variable_definition(state, ast);
         break;
     case AstKind::VariableReference:
-        compile_variable_reference(state, ast, scope);
+        compile_variable_reference(state, ast);
         break;
     case AstKind::Assignment:
-        compile_assignment(state, ast, scope);
+        compile_assignment(state, ast);
         break;
     case AstKind::IndexExpression:
-        compile_index_expression(state, ast, scope);
+        compile_index_expression(state, ast);
         break;
     case AstKind::Function:
-        if (ast->data.function.body != nullptr) {
-            compile_function_definition(state, ast, scope);
+        if (ast_get<Function>(state->asts, ast).body != AST_NULL) {
+            compile_function_definition(state, ast);
         } else {
-            compile_function_declaration(state, ast, scope);
+            compile_function_declaration(state, ast);
         }
         break;
     case AstKind::FunctionCall:
-        compile_function_call(state, ast, scope);
+        compile_function_call(state, ast);
         break;
     case AstKind::CndStmt:
-        compile_cnd_stmt(state, ast, scope);
+        compile_cnd_stmt(state, ast);
         break;
     case AstKind::WhlStmt:
-        compile_whl_stmt(state, ast, scope);
+        compile_whl_stmt(state, ast);
         break;
     case AstKind::ForStmt:
-        compile_for_stmt(state, ast, scope);
+        compile_for_stmt(state, ast);
         break;
     case AstKind::RetStmt:
-        compile_ret_stmt(state, ast, scope);
+        compile_ret_stmt(state, ast);
         break;
     case AstKind::Block:
-        compile_block(state, ast, scope);
+        compile_block(state, ast);
         break;
     case AstKind::ArithmeticOperation:
-        compile_arithmetic_operation(state, ast, scope);
+        compile_arithmetic_operation(state, ast);
         break;
     case AstKind::BooleanOperation:
-        compile_boolean_operation(state, ast, scope);
+        compile_boolean_operation(state, ast);
         break;
     case AstKind::BuiltinFunction:
-        compile_builtin_function(state, ast, scope);
+        compile_builtin_function(state, ast);
         break;
     }
 }
@@ -728,13 +722,24 @@ void make_start(CompilerState *state) {
     asm_add_instruction(state->code, "syscall");
 }
 
-void compile(CompilerState *state, Program const &program) {
-    for (auto ast : program.code) {
-        compile_ast(state, ast, program.scope);
-    }
-    if (scope_lookup_symbol(program.scope, "main")) {
+// The functions are compiled in parallel, each one in its own buffer and with
+// its index in the program as label namespace. The buffers are returned in the
+// order of the program (followed by the entry point), so the output does not
+// depend on the number of threads.
+std::vector<Asm> compile(CompilerState *state, Program const &program, size_t jobs) {
+    std::vector<Asm> code(program.code.size());
+
+    parallel_for(program.code.size(), jobs, [&](size_t idx) {
+        CompilerState function_state = *state;
+        function_state.label_namespace = idx;
+        compile_ast(&function_state, program.code[idx]);
+        code[idx] = std::move(function_state.code);
+    });
+    if (scope_lookup_symbol(program.scope, intern("main")) != SYMBOL_NONE) {
         make_start(state);
+        code.push_back(std::move(state->code));
     }
+    return code;
 }
 
 } // namespace gnu_linux
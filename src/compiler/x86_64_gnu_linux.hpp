@@ -11,7 +11,7 @@ namespace x86_64 {
 
 namespace gnu_linux {
 
-void compile(CompilerState *state, Program const &program);
+std::vector<Asm> compile(CompilerState *state, Program const &program, size_t jobs);
 
 } // end namespace gnu_linux
 
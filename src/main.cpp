@@ -1,19 +1,32 @@
+#include "compiler/cache.hpp"
 #include "compiler/compiler.hpp"
+#include "compiler/linker.hpp"
 #include "compiler/tools.hpp"
 #include "parser/lexer.hpp"
 #include "parser/parser.hpp"
 #include "preprocessor/preprocessor.hpp"
+#include "module.hpp"
 #include "s3c.hpp"
+#include "resolve.hpp"
 #include "checks.hpp"
 #include "tools/messages.hpp"
 #include "tools/defer.hpp"
+#include "tools/intern.hpp"
 #include "tools/string.hpp"
+#include "tools/parallel.hpp"
+#include "tools/server.hpp"
+#include "tools/time_report.hpp"
 #include <filesystem>
+#include <fstream>
 #include <cassert>
-#define PREPROCESSOR_OUTPUT_FILE "__main_pp__"
+#include <mutex>
+#include <set>
+
+// number of identifiers above which the server clears the intern table
+#define INTERN_RESET_THRESHOLD (1 << 20)
 
 struct Options {
-    std::string input_file; // TODO: will be changed to a list
+    std::vector<std::string> input_files;
     std::string output_file;
     std::string build_directory_name;
     enum {
@@ -21,78 +34,137 @@ struct Options {
         GenerateAssembly,
     } generate_option;
     std::vector<std::string> linker_options;
+    size_t jobs; // number of threads (files compiled and functions checked in parallel)
+    bool use_cache;
+    std::vector<std::string> code_options; // options in the build cache key
+    bool time_report;
+    std::string time_report_json; // file in which the json report is written
+    bool alloc_report;
 };
 
-Options parse_args(std::vector<std::string> const &args) {
-    Options opts = {
-        .input_file = "",
+// the errors are reported instead of exiting since the server reuses this
+bool parse_args(std::vector<std::string> const &args, Options &opts) {
+    opts = {
+        .input_files = {},
         .output_file = "bin",
         .build_directory_name = "build/",
         .generate_option = Options::GenerateExecutable,
         .linker_options = {},
+        .jobs = 1,
+        .use_cache = true,
+        .code_options = {},
+        .time_report = false,
+        .time_report_json = "",
+        .alloc_report = false,
     };
     auto arg = args.begin();
 
     while (arg != args.end()) {
+        // the options are part of the key of the build cache unless they are
+        // known not to change the generated code (see below)
+        auto option = arg;
+        bool changes_code = true;
+
         if (*arg == "-o" || *arg == "--output") {
+            changes_code = false;
             arg++;
             if (arg == args.end()) {
-                std::cerr << "error: expected file name after " << *arg << "."
-                          << std::endl;
-                exit(1);
+                std::cerr << "error: expected file name after " << *(arg - 1)
+                          << "." << std::endl;
+                return false;
             }
             opts.output_file = *arg;
         } else if (starts_with(*arg, "--output=")) {
+            changes_code = false;
             opts.output_file = arg->substr(9);
         } else if (*arg == "--build-dir") {
+            changes_code = false;
             arg++;
             if (arg == args.end()) {
-                std::cerr << "error: expected directory name after " << *arg
-                          << "." << std::endl;
-                exit(1);
+                std::cerr << "error: expected directory name after "
+                          << *(arg - 1) << "." << std::endl;
+                return false;
             }
             opts.build_directory_name = *arg;
         } else if (starts_with(*arg, "--build-dir=")) {
+            changes_code = false;
             opts.build_directory_name = arg->substr(12);
         } else if (starts_with(*arg, "-L")) {
+            changes_code = false;
             opts.linker_options.push_back(*arg);
             if (arg->size() == 2) {
                 arg++;
                 if (arg == args.end()) {
-                    std::cerr << "error: expected file name after " << *arg
-                              << "." << std::endl;
-                    exit(1);
+                    std::cerr << "error: expected file name after "
+                              << *(arg - 1) << "." << std::endl;
+                    return false;
                 }
                 opts.linker_options.push_back(*arg);
             }
         } else if (starts_with(*arg, "-l")) {
+            changes_code = false;
             opts.linker_options.push_back(*arg);
         } else if (starts_with(*arg, "-rpath=")) {
+            changes_code = false;
             opts.linker_options.push_back(*arg);
         } else if (*arg == "-S") {
             opts.generate_option = Options::GenerateAssembly;
+        } else if (*arg == "--no-cache") {
+            changes_code = false;
+            opts.use_cache = false;
+        } else if (*arg == "--time-report") {
+            changes_code = false;
+            opts.time_report = true;
+        } else if (starts_with(*arg, "--time-report-json=")) {
+            changes_code = false;
+            opts.time_report_json = arg->substr(19);
+        } else if (*arg == "--alloc-report") {
+            changes_code = false;
+            opts.alloc_report = true;
+        } else if (starts_with(*arg, "-j") || starts_with(*arg, "--jobs=")) {
+            changes_code = false; // the output does not depend on the threads
+            std::string jobs = starts_with(*arg, "-j") ? arg->substr(2) : arg->substr(7);
+            if (jobs.empty()) {
+                arg++;
+                if (arg == args.end()) {
+                    std::cerr << "error: expected number of jobs after -j."
+                              << std::endl;
+                    return false;
+                }
+                jobs = *arg;
+            }
+            int nb_jobs = std::atoi(jobs.c_str());
+            if (nb_jobs <= 0) {
+                std::cerr << "error: invalid number of jobs " << jobs << "."
+                          << std::endl;
+                return false;
+            }
+            opts.jobs = (size_t)nb_jobs;
         } else if ((*arg)[0] == '-') {
             std::cerr << "error: unknown option " << *arg << "." << std::endl;
-            exit(1);
+            return false;
         } else {
-            opts.input_file = *arg;
+            changes_code = false; // the content of the unit is in the key
+            opts.input_files.push_back(*arg);
+        }
+        if (changes_code) {
+            opts.code_options.insert(opts.code_options.end(), option, arg + 1);
         }
         arg++;
     }
-    if (opts.input_file.empty()) {
+    if (opts.input_files.empty()) {
         std::cerr << "error: no input file." << std::endl;
-        exit(1);
+        return false;
     }
     if (opts.output_file.empty()) {
+        std::string const &input_file = opts.input_files[0];
         if (opts.generate_option == Options::GenerateExecutable) {
-            opts.output_file =
-                opts.input_file.substr(0, opts.input_file.size() - 2);
+            opts.output_file = input_file.substr(0, input_file.size() - 2);
         } else {
-            opts.output_file =
-                opts.input_file.substr(0, opts.input_file.size() - 1) + "asm";
+            opts.output_file = input_file.substr(0, input_file.size() - 1) + "asm";
         }
     }
-    return opts;
+    return true;
 }
 
 /* add execution rights to the result file */
@@ -110,11 +182,11 @@ void make_directory(std::string const &directory_name) {
     }
 }
 
-bool preprocess(Options const &opts) {
-    Preprocessor pp(opts.build_directory_name + PREPROCESSOR_OUTPUT_FILE);
-
+bool preprocess(std::string const &input_file,
+                std::string const &module_directory, Preprocessor &pp) {
+    PhaseTimer timer(Phase::Preprocess);
     try {
-        pp.process(opts.input_file); // launch the preprocessor
+        pp.process(input_file, module_directory); // launch the preprocessor
     } catch (std::logic_error &e) {
         msg::error(e.what());
         return false;
@@ -122,80 +194,285 @@ bool preprocess(Options const &opts) {
     return true;
 }
 
-bool parse(Options const &opts, State *state) {
-    // BUG: when declaring a string here, its destructor ends up crashing???
-    // std::string pp_file = opts.build_directory_name + PREPROCESSOR_OUTPUT_FILE;
-    std::ifstream is(opts.build_directory_name + PREPROCESSOR_OUTPUT_FILE, std::ios::in);
-    assert(is.good());
+// the scanner reads the preprocessor output directly from memory (the tokens
+// refer to the output)
+bool parse(Preprocessor const &pp, State *state) {
+    PhaseTimer timer(Phase::Parse);
+    // the used files that have an interface are not in the output
+    for (auto const &used_file : pp.usedFiles()) {
+        if (!used_file.interfaceFile.empty() &&
+            !module_interface_load(state, used_file.interfaceFile,
+                                   used_file.fileName)) {
+            return false;
+        }
+    }
     assert(state != nullptr);
-    parser::Scanner scanner(is, std::cerr);
+    parser::Scanner scanner(pp.output());
     parser::Parser parser(scanner, state);
     int err = parser.parse();
     bool result = !(err || state->status);
     return result;
 }
 
-bool compile(Options const &opts) {
-    State *state = state_create();
-    defer(state_destroy(state));
+// The states are reset and reused instead of being destroyed, so the server
+// keeps its pools and arenas between the requests.
+static std::mutex free_states_mutex;
+static std::vector<State *> free_states;
 
-    make_directory(opts.build_directory_name);
+State *state_acquire() {
+    std::lock_guard<std::mutex> lock(free_states_mutex);
+    if (free_states.empty()) {
+        return state_create();
+    }
+    State *state = free_states.back();
+    free_states.pop_back();
+    return state;
+}
+
+void state_release(State *state) {
+    state_reset(state);
+    std::lock_guard<std::mutex> lock(free_states_mutex);
+    free_states.push_back(state);
+}
 
-    if (!preprocess(opts)) {
+void destroy_free_states() {
+    for (State *state : free_states) {
+        state_destroy(state);
+    }
+    free_states.clear();
+}
+
+// allocation statistics of all the units (--alloc-report)
+static std::mutex alloc_stats_mutex;
+static std::map<std::string, AllocStats> alloc_stats;
+
+void collect_alloc_stats(State *state) {
+    std::lock_guard<std::mutex> lock(alloc_stats_mutex);
+    alloc_stats_merge(alloc_stats, state->tracking.stats);
+}
+
+// Compile one input file to an object file (or to an assembly file when -S is
+// used). Each unit has its own state so units can be compiled in parallel.
+bool compile_unit(Options const &opts, std::string const &input_file,
+                  std::string const &output_file) {
+    State *state = state_acquire();
+    defer(state_release(state));
+    state_track_allocations(state, opts.alloc_report);
+    defer(if (opts.alloc_report) { collect_alloc_stats(state); });
+    // the messages of the unit are kept to be stored in the build cache
+    std::string messages;
+    std::string *previous_capture = msg::capture(&messages);
+    defer(msg::capture(previous_capture); msg::print(messages));
+
+    // the module interfaces are cached as well
+    std::string module_directory;
+    if (opts.use_cache) {
+        module_directory = opts.build_directory_name + "/modules";
+    }
+    Preprocessor pp;
+    if (!preprocess(input_file, module_directory, pp)) {
+        return false;
+    }
+
+    // the object files are cached (the assembly output is always generated)
+    bool use_cache = opts.use_cache &&
+                     opts.generate_option == Options::GenerateExecutable;
+    std::string cache_file;
+    if (use_cache) {
+        std::vector<std::string> flags = {"x86_64", "gnu_linux"};
+        flags.insert(flags.end(), opts.code_options.begin(),
+                     opts.code_options.end());
+        for (auto const &used_file : pp.usedFiles()) {
+            if (!used_file.interfaceFile.empty()) {
+                flags.push_back(used_file.interfaceFile);
+            }
+        }
+        auto key = compiler::cache_key(pp.output(), flags);
+        cache_file = compiler::cache_filename(opts.build_directory_name, key);
+        if (compiler::cache_load(cache_file, output_file, &messages)) {
+            return true;
+        }
+    }
+
+    tracking_allocator_set_tag(&state->tracking, "parse");
+    if (!parse(pp, state)) {
         return false;
     }
 
-    if (!parse(opts, state)) {
+    tracking_allocator_set_tag(&state->tracking, "resolve");
+    ResolveState resolve_state = {&state->asts, &state->types, state->allocator, state->global_scope, &state->symbols};
+    if (!resolve(&resolve_state, state->program)) {
         return false;
     }
 
-    CheckState check_state = {nullptr, &state->type_pool, state->allocator, state->global_scope};
-    if (!check(&check_state, Program{state->program, state->global_scope})) {
+    tracking_allocator_set_tag(&state->tracking, "check");
+    Program program = {&state->asts, state->program, state->global_scope, &state->expr_types, &state->symbols};
+    // the threads are shared by the units compiled in parallel
+    size_t unit_jobs = std::max(opts.jobs / opts.input_files.size(), (size_t)1);
+    CheckState check_state = {AST_NULL, &state->types, &state->asts, &state->expr_types, &state->symbols, unit_jobs};
+    if (!check(&check_state, program)) {
         return false;
     }
 
+    // save the interfaces of the checked modules (only the ones that contain
+    // declarations are written)
+    for (auto const &used_file : pp.usedFiles()) {
+        if (!module_directory.empty() && used_file.interfaceFile.empty() &&
+            !used_file.hasUse) {
+            module_interface_store(
+                module_interface_filename(module_directory, used_file.hash),
+                used_file.fileName, program);
+        }
+    }
+
     // look for main
     if (!try_verify_main_type(state)) {
         return false;
     }
 
-    if (opts.generate_option == Options::GenerateAssembly) {
-        auto base_name = compiler::base_name(opts.input_file);
-        auto asm_file = compiler::asm_filename(base_name);
-        compiler::compile(asm_file, compiler::Arch::X86_64,
-                          compiler::Platform::GNULinux,
-                          Program{state->program, state->global_scope});
-    } else {
-        auto base_name =
-            opts.build_directory_name + compiler::base_name(opts.input_file);
-        auto asm_file = compiler::asm_filename(base_name);
-        auto obj_file = compiler::object_filename(base_name);
-
-        compiler::compile(asm_file, compiler::Arch::X86_64,
-                          compiler::Platform::GNULinux,
-                          Program{state->program, state->global_scope});
-        int assembler_success = compiler::run_cmd("as", "-g", "-msyntax=intel",
-                                                  asm_file, "-o", obj_file);
-        if (assembler_success == 0) {
-            compiler::run_cmd("ld", "-o", opts.output_file, obj_file, "-lc",
+    auto format = opts.generate_option == Options::GenerateAssembly
+                      ? compiler::OutputFormat::Assembly
+                      : compiler::OutputFormat::Object;
+    if (!compiler::compile(output_file, compiler::Arch::X86_64,
+                           compiler::Platform::GNULinux, format, program,
+                           unit_jobs)) {
+        return false;
+    }
+
+    if (use_cache) {
+        compiler::cache_store(output_file, cache_file, messages);
+    }
+    return true;
+}
+
+bool compile(Options const &opts) {
+    std::vector<std::string> output_files;
+    std::set<std::string> base_names;
+
+    make_directory(opts.build_directory_name);
+
+    for (auto const &input_file : opts.input_files) {
+        auto base_name = compiler::base_name(input_file);
+        if (base_names.count(base_name)) {
+            msg::error("multiple input files named " + base_name + ".3.");
+            return false;
+        }
+        base_names.insert(base_name);
+        if (opts.generate_option == Options::GenerateAssembly) {
+            output_files.push_back(compiler::asm_filename(base_name));
+        } else {
+            // the object file is encoded directly (no assembler)
+            output_files.push_back(compiler::object_filename(
+                opts.build_directory_name + base_name));
+        }
+    }
+
+    std::vector<char> results(opts.input_files.size(), false);
+    parallel_for(opts.input_files.size(), opts.jobs, [&](size_t idx) {
+        results[idx] = compile_unit(opts, opts.input_files[idx], output_files[idx]);
+    });
+    if (std::find(results.begin(), results.end(), false) != results.end()) {
+        return false;
+    }
+
+    if (opts.generate_option == Options::GenerateExecutable) {
+        PhaseTimer timer(Phase::Link);
+        std::vector<compiler::ObjectFile> objects(output_files.size());
+        for (size_t i = 0; i < output_files.size(); ++i) {
+            if (!compiler::elf_read(output_files[i], objects[i])) {
+                return false;
+            }
+        }
+        // ld is only required when external functions are used (or when
+        // linker options are given, the static linker does not support them)
+        if (opts.linker_options.empty() &&
+            compiler::static_link_possible(objects)) {
+            if (!compiler::static_link(objects, opts.output_file)) {
+                return false;
+            }
+            make_file_executable(opts.output_file);
+        } else if (compiler::run_cmd("ld", "-o", opts.output_file, output_files, "-lc",
                               "-dynamic-linker", "/lib64/ld-linux-x86-64.so.2",
-                              opts.linker_options);
+                              opts.linker_options) != 0) {
+            return false;
         }
     }
     return true;
 }
 
+// run one compilation (from the command line or from a server request)
+int run(std::vector<std::string> const &args) {
+    Options opts;
+
+    if (!parse_args(args, opts)) {
+        return 1;
+    }
+    // The identifiers are never released, so the server clears the table
+    // between two requests when it becomes large (the free states use it).
+    if (intern_count() > INTERN_RESET_THRESHOLD) {
+        destroy_free_states();
+        intern_reset();
+    }
+    time_report_enable(opts.time_report || !opts.time_report_json.empty());
+    time_report_clear();
+    alloc_stats.clear();
+
+    bool ok = compile(opts);
+
+    if (opts.time_report) {
+        time_report_print(std::cerr);
+    }
+    if (opts.alloc_report) {
+        alloc_stats_print(std::cerr, alloc_stats);
+    }
+    if (!opts.time_report_json.empty()) {
+        std::ofstream fs(opts.time_report_json);
+        if (!fs.good()) {
+            std::cerr << "error: cannot open " << opts.time_report_json << "."
+                      << std::endl;
+            return 1;
+        }
+        time_report_print_json(fs);
+    }
+    if (!ok) {
+        std::cerr << "Compilation failed!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// --server[=socket], --connect[=socket] and --server-stop[=socket]
+bool server_option(std::string const &arg, std::string const &option,
+                   std::string &socket_path) {
+    if (arg == option) {
+        socket_path = server_default_socket();
+        return true;
+    }
+    if (starts_with(arg, option + "=")) {
+        socket_path = arg.substr(option.size() + 1);
+        return true;
+    }
+    return false;
+}
+
 int main(int argc, char **argv) {
     std::vector<std::string> args;
+    std::string socket_path;
+    int status = 0;
 
     for (int i = 1; i < argc; ++i) {
         args.push_back(argv[i]);
     }
-    Options opts = parse_args(args);
 
-    if (!compile(opts)) {
-        std::cerr << "Compilation failed!" << std::endl;
-        return 1;
+    if (!args.empty() && server_option(args[0], "--server", socket_path)) {
+        status = server_run(socket_path, run) ? 0 : 1;
+    } else if (!args.empty() && server_option(args[0], "--connect", socket_path)) {
+        status = server_request(socket_path, {args.begin() + 1, args.end()});
+    } else if (!args.empty() && server_option(args[0], SERVER_STOP_REQUEST, socket_path)) {
+        status = server_request(socket_path, {SERVER_STOP_REQUEST});
+    } else {
+        status = run(args);
     }
-    return 0;
+    destroy_free_states();
+    return status;
 }
@@ -0,0 +1,217 @@
+#include "module.hpp"
+#include "s3c.hpp"
+#include "tools/hash.hpp"
+#include "tools/messages.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+uint64_t module_hash(char const *data, size_t size) {
+    std::string const version = MODULE_INTERFACE_VERSION;
+    uint64_t hash = hash_bytes(version.data(), version.size() + 1);
+    return hash_bytes(data, size, hash);
+}
+
+std::string module_interface_filename(std::string const &module_directory,
+                                      uint64_t hash) {
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << hash << ".3i";
+    return (std::filesystem::path(module_directory) / oss.str()).string();
+}
+
+/******************************************************************************/
+/*                                   write                                    */
+/******************************************************************************/
+
+static void write_u32(std::string &out, uint32_t value) {
+    out.append((char const *)&value, sizeof(value));
+}
+
+static void write_u64(std::string &out, uint64_t value) {
+    out.append((char const *)&value, sizeof(value));
+}
+
+static void write_identifier(std::string &out, Identifier const &identifier) {
+    write_u32(out, identifier.len);
+    out.append(identifier.view());
+}
+
+static void write_type_specifier(std::string &out, TypeSpecifier const &type) {
+    out.push_back((char)type.kind);
+    write_u64(out, type.size);
+    write_identifier(out, type.name);
+}
+
+// The interface is written only when all the functions of the module are
+// declarations (no code to compile).
+bool module_interface_store(std::string const &filename,
+                            std::string const &module_file,
+                            Program const &program) {
+    AstStorage const *asts = program.asts;
+    std::vector<AstId> declarations;
+    std::string out = MODULE_INTERFACE_VERSION;
+    IdentifierId module_file_id = intern(module_file).id;
+
+    for (AstId ast : program.code) {
+        if (ast_location(asts, ast).file != module_file_id) {
+            continue;
+        }
+        if (ast_get<Function>(asts, ast).body != AST_NULL) {
+            return false;
+        }
+        declarations.push_back(ast);
+    }
+
+    out.push_back('\0');
+    write_u32(out, (uint32_t)declarations.size());
+    for (AstId ast : declarations) {
+        auto const &function = ast_get<Function>(asts, ast);
+        write_u32(out, ast_location(asts, ast).row);
+        write_type_specifier(out, function.return_type_specifier);
+        write_identifier(out, function.name);
+        write_u32(out, (uint32_t)function.arguments.len);
+        for (AstId arg : function.arguments) {
+            auto const &definition = ast_get<VariableDefinition>(asts, arg);
+            write_u32(out, ast_location(asts, arg).row);
+            write_type_specifier(out, definition.type_specifier);
+            write_identifier(out, definition.name);
+        }
+    }
+
+    // written in a temporary file and renamed (parallel compilations may store
+    // the same interface)
+    std::error_code err;
+    std::ostringstream tmp_file;
+    tmp_file << filename << ".tmp" << getpid() << "-"
+             << std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::filesystem::create_directories(
+        std::filesystem::path(filename).parent_path(), err);
+    {
+        std::ofstream fs(tmp_file.str(), std::ios::binary);
+        fs.write(out.data(), (std::streamsize)out.size());
+        if (!fs.good()) {
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp_file.str(), filename, err);
+    return !err;
+}
+
+/******************************************************************************/
+/*                                    load                                    */
+/******************************************************************************/
+
+struct InterfaceReader {
+    std::string data;
+    size_t pos;
+    bool ok;
+};
+
+static uint32_t read_u32(InterfaceReader &reader) {
+    uint32_t value = 0;
+    if (reader.pos + sizeof(value) > reader.data.size()) {
+        reader.ok = false;
+        return 0;
+    }
+    memcpy(&value, reader.data.data() + reader.pos, sizeof(value));
+    reader.pos += sizeof(value);
+    return value;
+}
+
+static uint64_t read_u64(InterfaceReader &reader) {
+    uint64_t value = 0;
+    if (reader.pos + sizeof(value) > reader.data.size()) {
+        reader.ok = false;
+        return 0;
+    }
+    memcpy(&value, reader.data.data() + reader.pos, sizeof(value));
+    reader.pos += sizeof(value);
+    return value;
+}
+
+static Identifier read_identifier(InterfaceReader &reader) {
+    uint32_t len = read_u32(reader);
+    if (!reader.ok || len > reader.data.size() - reader.pos) {
+        reader.ok = false;
+        return Identifier{};
+    }
+    if (len == 0) {
+        return Identifier{}; // empty type names are not interned by the parser
+    }
+    auto identifier = intern(std::string_view(reader.data).substr(reader.pos, len));
+    reader.pos += len;
+    return identifier;
+}
+
+static TypeSpecifier read_type_specifier(InterfaceReader &reader) {
+    TypeSpecifier type = {};
+    if (reader.pos >= reader.data.size() ||
+        reader.data[reader.pos] > (char)TypeSpecifierKind::Obj) {
+        reader.ok = false;
+        return type;
+    }
+    type.kind = (TypeSpecifierKind)reader.data[reader.pos++];
+    type.size = read_u64(reader);
+    type.name = read_identifier(reader);
+    return type;
+}
+
+// the declarations are added to the program as if they were parsed
+bool module_interface_load(State *state, std::string const &filename,
+                           std::string const &module_file) {
+    std::ifstream fs(filename, std::ios::binary);
+    InterfaceReader reader = {
+        .data = std::string((std::istreambuf_iterator<char>(fs)),
+                            std::istreambuf_iterator<char>()),
+        .pos = 0,
+        .ok = true,
+    };
+    std::string const version = MODULE_INTERFACE_VERSION;
+
+    if (reader.data.compare(0, version.size() + 1,
+                            version.c_str(), version.size() + 1) != 0) {
+        msg::error("invalid module interface " + filename + ".");
+        return false;
+    }
+    reader.pos = version.size() + 1;
+
+    IdentifierId module_file_id = intern(module_file).id;
+    uint32_t nb_functions = read_u32(reader);
+    for (uint32_t i = 0; reader.ok && i < nb_functions; ++i) {
+        size_t row = read_u32(reader);
+        TypeSpecifier return_type = read_type_specifier(reader);
+        Identifier name = read_identifier(reader);
+        uint32_t nb_args = read_u32(reader);
+        std::vector<AstId> args;
+        for (uint32_t j = 0; reader.ok && j < nb_args; ++j) {
+            size_t arg_row = read_u32(reader);
+            TypeSpecifier arg_type = read_type_specifier(reader);
+            Identifier arg_name = read_identifier(reader);
+            args.push_back(new_ast(
+                &state->asts, location_create(module_file_id, arg_row),
+                VariableDefinition{
+                    .type_specifier = arg_type,
+                    .name = arg_name,
+                    .symbol = SYMBOL_NONE,
+                }));
+        }
+        add_function(state, new_ast(
+            &state->asts, location_create(module_file_id, row),
+            Function{
+                .return_type_specifier = return_type,
+                .name = name,
+                .arguments = ast_list_create(args, state->allocator),
+                .body = AST_NULL,
+                .symbol = SYMBOL_NONE,
+            }));
+    }
+    if (!reader.ok) {
+        msg::error("invalid module interface " + filename + ".");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef MODULE
+#define MODULE
+#include "program.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct State;
+
+/*
+ * Module interfaces: a file included with `use` that only contains function
+ * declarations (`dcl`) and that doesn't use other files is saved in a compact
+ * binary file in the build directory after it has been checked. The next
+ * compilations load the declarations from this file instead of parsing the
+ * source again. The interfaces are indexed by a hash of the source file.
+ */
+
+// must be changed whenever the format of the interfaces changes
+#define MODULE_INTERFACE_VERSION "s3c-module-1"
+
+uint64_t module_hash(char const *data, size_t size);
+std::string module_interface_filename(std::string const &module_directory,
+                                      uint64_t hash);
+bool module_interface_store(std::string const &filename,
+                            std::string const &module_file,
+                            Program const &program);
+bool module_interface_load(State *state, std::string const &filename,
+                           std::string const &module_file);
+
+#endif
@@ -0,0 +1,370 @@
+#include "lexer.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+// LEXER_NO_SIMD can be defined to compare with the scalar version (cmake
+// -DLEXER_NO_SIMD=ON, the lexer tests must pass with both versions)
+#if defined(__SSE2__) && !defined(LEXER_NO_SIMD)
+#define LEXER_SSE2
+#include <emmintrin.h>
+#endif
+#define DBG_LEX 0
+#if DBG_LEX == 1
+#define DEBUG(A) std::cout << A << std::endl
+#else
+#define DEBUG(A)
+#endif
+
+/*
+ * The tokens are the same as the ones of the previous flex lexer (longest
+ * match, keywords are only recognized when the whole identifier matches):
+ *
+ * alpha      [a-zA-Z]
+ * int        [+-]?{digit}+
+ * float      [+-]?{digit}+\.{digit}+
+ * char       '{alpha}'
+ * identifier {alpha}({alpha}|{digit}|_)*
+ * string     \"(\\.|[^"\\])*\"
+ * comment    \~\~\~.*$
+ * file       -->.+-{digit}+\n
+ *
+ * The spaces and the tabs are ignored and the other characters are returned
+ * as they are. Only the new lines update the location.
+ */
+
+namespace parser {
+
+using token = Parser::token;
+
+enum CharClass : uint8_t {
+    Alpha = 1,
+    Digit = 2,
+    Underscore = 4,
+};
+
+struct CharClasses {
+    uint8_t classes[256] = {};
+
+    constexpr CharClasses() {
+        for (int c = 'a'; c <= 'z'; ++c) {
+            classes[c] = Alpha;
+            classes[c - 'a' + 'A'] = Alpha;
+        }
+        for (int c = '0'; c <= '9'; ++c) {
+            classes[c] = Digit;
+        }
+        classes['_'] = Underscore;
+    }
+};
+
+static constexpr CharClasses char_classes;
+
+static bool is_alpha(char c) {
+    return char_classes.classes[(uint8_t)c] & Alpha;
+}
+
+static bool is_digit(char c) {
+    return char_classes.classes[(uint8_t)c] & Digit;
+}
+
+static bool is_identifier_char(char c) {
+    return char_classes.classes[(uint8_t)c] != 0;
+}
+
+/******************************************************************************/
+/*                             scanning functions                             */
+/******************************************************************************/
+
+// The loops process 16 bytes at a time using SSE2 (always available on
+// x86_64), the end of the buffer is processed one byte at a time.
+
+#ifdef LEXER_SSE2
+// bit i of the result is set if the byte i is in [lo, hi]
+static int sse2_in_range(__m128i chars, char lo, char hi) {
+    __m128i ge = _mm_cmpgt_epi8(chars, _mm_set1_epi8((char)(lo - 1)));
+    __m128i le = _mm_cmplt_epi8(chars, _mm_set1_epi8((char)(hi + 1)));
+    return _mm_movemask_epi8(_mm_and_si128(ge, le));
+}
+
+static int sse2_equal(__m128i chars, char c) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8(c)));
+}
+#endif
+
+// first character that is not a space or a tab
+static char const *skip_blanks(char const *cur, char const *end) {
+    // most tokens are separated by a single space
+    if (cur < end && *cur != ' ' && *cur != '\t') {
+        return cur;
+    }
+#ifdef LEXER_SSE2
+    for (; end - cur >= 16; cur += 16) {
+        __m128i chars = _mm_loadu_si128((__m128i const *)cur);
+        int blanks = sse2_equal(chars, ' ') | sse2_equal(chars, '\t');
+        if (blanks != 0xFFFF) {
+            return cur + __builtin_ctz(~blanks);
+        }
+    }
+#endif
+    while (cur < end && (*cur == ' ' || *cur == '\t')) {
+        ++cur;
+    }
+    return cur;
+}
+
+// first character that cannot be part of an identifier
+static char const *skip_identifier(char const *cur, char const *end) {
+    // short identifiers are faster to scan one byte at a time
+    for (char const *short_end = cur + 8; cur < short_end && cur < end; ++cur) {
+        if (!is_identifier_char(*cur)) {
+            return cur;
+        }
+    }
+#ifdef LEXER_SSE2
+    for (; end - cur >= 16; cur += 16) {
+        __m128i chars = _mm_loadu_si128((__m128i const *)cur);
+        // setting the bit 0x20 converts upper case letters to lower case
+        __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+        int identifier = sse2_in_range(lower, 'a', 'z') |
+                         sse2_in_range(chars, '0', '9') | sse2_equal(chars, '_');
+        if (identifier != 0xFFFF) {
+            return cur + __builtin_ctz(~identifier);
+        }
+    }
+#endif
+    while (cur < end && is_identifier_char(*cur)) {
+        ++cur;
+    }
+    return cur;
+}
+
+// first new line (or end)
+static char const *find_line_end(char const *cur, char const *end) {
+#ifdef LEXER_SSE2
+    for (; end - cur >= 16; cur += 16) {
+        __m128i chars = _mm_loadu_si128((__m128i const *)cur);
+        int new_lines = sse2_equal(chars, '\n');
+        if (new_lines != 0) {
+            return cur + __builtin_ctz(new_lines);
+        }
+    }
+#endif
+    while (cur < end && *cur != '\n') {
+        ++cur;
+    }
+    return cur;
+}
+
+// first quote or backslash (or end)
+static char const *find_string_special(char const *cur, char const *end) {
+#ifdef LEXER_SSE2
+    for (; end - cur >= 16; cur += 16) {
+        __m128i chars = _mm_loadu_si128((__m128i const *)cur);
+        int specials = sse2_equal(chars, '"') | sse2_equal(chars, '\\');
+        if (specials != 0) {
+            return cur + __builtin_ctz(specials);
+        }
+    }
+#endif
+    while (cur < end && *cur != '"' && *cur != '\\') {
+        ++cur;
+    }
+    return cur;
+}
+
+/******************************************************************************/
+/*                                   tokens                                   */
+/******************************************************************************/
+
+// all the keywords have 3 characters
+static int keyword(char const *str) {
+#define KEYWORD(a, b, c) (((uint32_t)(a) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(c))
+    switch (KEYWORD(str[0], str[1], str[2])) {
+    case KEYWORD('i', 'n', 't'): return token::INTT;
+    case KEYWORD('f', 'l', 't'): return token::FLTT;
+    case KEYWORD('c', 'h', 'r'): return token::CHRT;
+    case KEYWORD('s', 't', 'r'): return token::STRT;
+    case KEYWORD('c', 'n', 'd'): return token::CND;
+    case KEYWORD('o', 't', 'w'): return token::OTW;
+    case KEYWORD('w', 'h', 'l'): return token::WHL;
+    case KEYWORD('f', 'o', 'r'): return token::FOR;
+    case KEYWORD('s', 'h', 'w'): return token::SHW;
+    case KEYWORD('i', 'p', 't'): return token::IPT;
+    case KEYWORD('a', 'd', 'd'): return token::ADD;
+    case KEYWORD('s', 'u', 'b'): return token::SUB;
+    case KEYWORD('m', 'u', 'l'): return token::MUL;
+    case KEYWORD('d', 'i', 'v'): return token::DIV;
+    case KEYWORD('e', 'q', 'l'): return token::EQL;
+    case KEYWORD('s', 'u', 'p'): return token::SUP;
+    case KEYWORD('i', 'n', 'f'): return token::INF;
+    case KEYWORD('s', 'e', 'q'): return token::SEQ;
+    case KEYWORD('i', 'e', 'q'): return token::IEQ;
+    case KEYWORD('a', 'n', 'd'): return token::AND;
+    case KEYWORD('l', 'o', 'r'): return token::LOR;
+    case KEYWORD('x', 'o', 'r'): return token::XOR;
+    case KEYWORD('n', 'o', 't'): return token::NOT;
+    case KEYWORD('m', 'o', 'v'): return token::MOV;
+    case KEYWORD('r', 'e', 't'): return token::RET;
+    case KEYWORD('d', 'c', 'l'): return token::DCL;
+    case KEYWORD('b', 'g', 'n'): return token::BGN;
+    case KEYWORD('e', 'n', 'd'): return token::END;
+    case KEYWORD('n', 'i', 'l'): return token::NIL;
+    }
+#undef KEYWORD
+    return token::IDENTIFIER;
+}
+
+// `-->file-line\n`, returns the end of the marker (nullptr if the line is not a
+// file marker)
+static char const *file_marker(char const *cur, char const *end,
+                               std::string_view &filename, size_t &line) {
+    char const *line_end = find_line_end(cur, end);
+    char const *dash = line_end;
+
+    if (line_end == end) {
+        return nullptr;
+    }
+    while (dash > cur && is_digit(dash[-1])) {
+        --dash;
+    }
+    // at least one digit and one character in the file name
+    if (dash == line_end || dash - cur < 5 || dash[-1] != '-') {
+        return nullptr;
+    }
+    line = 0;
+    for (char const *digit = dash; digit < line_end; ++digit) {
+        line = line * 10 + (size_t)(*digit - '0');
+    }
+    filename = std::string_view(cur + 3, (size_t)(dash - 1 - (cur + 3)));
+    return line_end + 1;
+}
+
+// end of the string literal that starts at `cur` (nullptr if the string is not
+// terminated)
+static char const *string_end(char const *cur, char const *end) {
+    for (cur = cur + 1;;) {
+        cur = find_string_special(cur, end);
+        if (cur == end) {
+            return nullptr;
+        } else if (*cur == '"') {
+            return cur + 1;
+        } else if (cur + 1 == end || cur[1] == '\n') { // `\\.`
+            return nullptr;
+        }
+        cur += 2;
+    }
+}
+
+int Scanner::lex(Parser::semantic_type *yylval, Parser::location_type *yylloc) {
+    for (;;) {
+        cur = skip_blanks(cur, end);
+        if (cur == end) {
+            return 0;
+        }
+        char const *begin = cur;
+        char c = *cur;
+
+        if (c == '\n') {
+            ++cur;
+            yylloc->lines(1);
+            yylloc->step();
+            continue;
+        }
+
+        if (is_alpha(c)) {
+            cur = skip_identifier(cur + 1, end);
+            int tok = cur - begin == 3 ? keyword(begin) : token::IDENTIFIER;
+            if (tok == token::IDENTIFIER) {
+                DEBUG("L_id");
+                yylval->build<std::string_view>(
+                    std::string_view(begin, (size_t)(cur - begin)));
+            }
+            return tok;
+        }
+
+        char const *digits = (c == '+' || c == '-') ? cur + 1 : cur;
+        if (digits < end && is_digit(*digits)) {
+            cur = digits;
+            while (cur < end && is_digit(*cur)) {
+                ++cur;
+            }
+            if (cur + 1 < end && *cur == '.' && is_digit(cur[1])) {
+                DEBUG("L_flt");
+                cur += 1;
+                while (cur < end && is_digit(*cur)) {
+                    ++cur;
+                }
+                std::string text(begin, (size_t)(cur - begin));
+                yylval->build<double>(std::atof(text.c_str()));
+                return token::FLT;
+            }
+            DEBUG("L_int");
+            unsigned long long value = 0;
+            for (char const *digit = digits; digit < cur; ++digit) {
+                value = value * 10 + (unsigned long long)(*digit - '0');
+            }
+            yylval->build<long long>(c == '-' ? -(long long)value : (long long)value);
+            return token::INT;
+        }
+
+        switch (c) {
+        case '"': {
+            char const *str_end = string_end(cur, end);
+            if (str_end == nullptr) {
+                break;
+            }
+            DEBUG("L_string");
+            cur = str_end;
+            yylval->build<std::string_view>(
+                std::string_view(begin, (size_t)(cur - begin)));
+            return token::STRING;
+        }
+        case '\'':
+            if (end - cur >= 3 && is_alpha(cur[1]) && cur[2] == '\'') {
+                DEBUG("L_chr");
+                cur += 3;
+                yylval->build<char>(begin[1]);
+                return token::CHR;
+            }
+            break;
+        case '~':
+            if (end - cur >= 3 && cur[1] == '~' && cur[2] == '~') {
+                char const *line_end = find_line_end(cur, end);
+                if (line_end != end) { // `$` requires a new line
+                    DEBUG("L_comment");
+                    cur = line_end;
+                    continue;
+                }
+            }
+            break;
+        case '-':
+            if (end - cur >= 3 && cur[1] == '-' && cur[2] == '>') {
+                std::string_view filename;
+                size_t line = 0;
+                char const *marker_end = file_marker(cur, end, filename, line);
+                if (marker_end != nullptr) {
+                    DEBUG("L_file");
+                    cur = marker_end;
+                    // reinitialize the location (note: the file is manage
+                    // manually in the parser)
+                    yylloc->initialize(nullptr);
+                    yylloc->lines((int)line);
+                    yylloc->step();
+                    yylval->build<std::string_view>(filename);
+                    return token::PREPROCESSOR_LOCATION;
+                }
+            }
+            break;
+        case ',': ++cur; return token::COMMA;
+        case ';': ++cur; return token::SEMI;
+        case '[': ++cur; return token::OSQUAREB;
+        case ']': ++cur; return token::CSQUAREB;
+        }
+        // any other character is returned as it is
+        ++cur;
+        return c;
+    }
+}
+
+} // namespace parser
@@ -1,19 +1,27 @@
 #ifndef LEXER_HPP
 #define LEXER_HPP
 #include "parser.hpp"
-#if !defined (yyFlexLexerOnce)
-#include <FlexLexer.h>
-#endif
+#include <string_view>
 
 namespace parser {
-class Scanner : public yyFlexLexer {
+
+/*
+ * Hand-written lexer working on the whole preprocessor output (contiguous
+ * buffer). The identifiers and the strings are views on the input, so the
+ * input must outlive the parsed program tokens (the parser copies them in the
+ * ast).
+ */
+class Scanner {
   public:
-    Scanner(std::istream &arg_yyin, std::ostream &arg_yyout)
-        : yyFlexLexer(arg_yyin, arg_yyout) {}
-    Scanner(std::istream *arg_yyin = nullptr, std::ostream *arg_yyout = nullptr)
-        : yyFlexLexer(arg_yyin, arg_yyout) {}
+    Scanner(std::string_view input)
+        : cur(input.data()), end(input.data() + input.size()) {}
     int lex(Parser::semantic_type *yylval, Parser::location_type *yylloc);
+
+  private:
+    char const *cur;
+    char const *end;
 };
+
 } // namespace parser
 
 #endif
@@ -8,7 +8,6 @@
 #include "s3c.hpp"
 #include "tools/messages.hpp"
 #define YYLOCATION_PRINT   location_print
-#define YYDEBUG 1
 #define DBG_PARS 0
 #if DBG_PARS == 1
 #define DEBUG(A) std::cout << A << std::endl
@@ -28,14 +27,17 @@
 
 %code requires
 {
+    // defined here so the parser class is the same in all the files
+    #define YYDEBUG 1
+    #include <string_view>
     #include "ast.hpp"
     #include "s3c.hpp"
     namespace parser {
         class Scanner;
     }
     struct CndContent {
-        Ast *block;
-        Ast *otw;
+        AstId block;
+        AstId otw;
     };
 }
 
@@ -57,39 +59,39 @@
 %token COMMA SEMI OSQUAREB CSQUAREB
 %token SHW IPT ADD SUB MUL DIV MOV
 %token EQL SUP INF SEQ IEQ AND LOR XOR NOT
-%token <std::string> IDENTIFIER
-%token <std::string> STRING
+%token <std::string_view> IDENTIFIER
+%token <std::string_view> STRING
 %token ERROR
 %token RET
 %token DCL
 %token BGN END
 %token TEXT
-%token <std::string> PREPROCESSOR_LOCATION
+%token <std::string_view> PREPROCESSOR_LOCATION
 
 %nterm <TypeSpecifier> type
-%nterm <Ast*> functionSignature
-%nterm <std::vector<Ast*>> parameterDeclarationList
-%nterm <std::vector<Ast*>> parameterList
-%nterm <Ast*> value
-%nterm <Ast*> assignment
-%nterm <Ast*> expression
-%nterm <Ast*> variable
-%nterm <Ast*> variableDefinition
-%nterm <Ast*> arithmeticOperation
-%nterm <Ast*> functionCall
-%nterm <Ast*> booleanOperation
-%nterm <Ast*> block
-%nterm <Ast*> cnd
-%nterm <Ast*> for
-%nterm <Ast*> whl
-%nterm <Ast*> ret
-%nterm <Ast*> instruction
-%nterm <Ast*> builtinFunctionCall
-%nterm <Ast*> controlStructure
-%nterm <std::vector<Ast*>> code
-%nterm <std::vector<Ast*>> instructions
+%nterm <AstId> functionSignature
+%nterm <ArrayBuilder<AstId>> parameterDeclarationList
+%nterm <ArrayBuilder<AstId>> parameterList
+%nterm <AstId> value
+%nterm <AstId> assignment
+%nterm <AstId> expression
+%nterm <AstId> variable
+%nterm <AstId> variableDefinition
+%nterm <AstId> arithmeticOperation
+%nterm <AstId> functionCall
+%nterm <AstId> booleanOperation
+%nterm <AstId> block
+%nterm <AstId> cnd
+%nterm <AstId> for
+%nterm <AstId> whl
+%nterm <AstId> ret
+%nterm <AstId> instruction
+%nterm <AstId> builtinFunctionCall
+%nterm <AstId> controlStructure
+%nterm <ArrayBuilder<AstId>> code
+%nterm <ArrayBuilder<AstId>> instructions
 %nterm <CndContent> cndContent
-%nterm <Ast*> optOtw
+%nterm <AstId> optOtw
 
 %start start
 
@@ -107,14 +109,14 @@ programUnit:
 functionSignature:
     type[rt] IDENTIFIER[name] '('parameterDeclarationList[args]')' {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @name.begin.line),
-            AstKind::Function,
-            .function = {
+            &state->asts,
+            location_create(state->curr_file, @name.begin.line),
+            Function{
                 .return_type_specifier = $rt,
-                .name = string_create($name, state->allocator),
-                .arguments = array_create_from_std_vector($args, state->allocator),
-                .body = nullptr,
+                .name = intern($name),
+                .arguments = ast_list_create($args, state->allocator),
+                .body = AST_NULL,
+                .symbol = SYMBOL_NONE,
             }
         );
     }
@@ -128,25 +130,31 @@ functionDeclaration:
 
 functionDefinition:
     functionSignature[function] block[body] {
-        $function->data.function.body = $body;
+        ast_get<Function>(&state->asts, $function).body = $body;
         add_function(state, $function);
     }
     ;
 
 parameterDeclarationList:
-    %empty { $$ = std::vector<Ast*>(); }
-    | variableDefinition { $$ = std::vector<Ast*>({$1}); }
+    %empty { $$ = ArrayBuilder<AstId>{}; }
+    | variableDefinition {
+        $$ = ArrayBuilder<AstId>{};
+        array_builder_append(&$$, $1, state->allocator);
+    }
     | parameterDeclarationList[args] COMMA variableDefinition[arg] {
-        $args.push_back($arg);
+        array_builder_append(&$args, $arg, state->allocator);
         $$ = $args;
     }
     ;
 
 parameterList:
-    %empty { $$ = std::vector<Ast*>(); }
-    | expression { $$ = std::vector<Ast*>({$1}); }
+    %empty { $$ = ArrayBuilder<AstId>{}; }
+    | expression {
+        $$ = ArrayBuilder<AstId>{};
+        array_builder_append(&$$, $1, state->allocator);
+    }
     | parameterList[args] COMMA expression[arg] {
-        $args.push_back($arg);
+        array_builder_append(&$args, $arg, state->allocator);
         $$ = $args;
     }
     ;
@@ -162,26 +170,25 @@ type:
 block:
     BGN code END {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::Block,
-            .block = { array_create_from_std_vector($code, state->allocator) }
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            Block{ ast_list_create($code, state->allocator) }
         );
     }
     ;
 
 code:
     instructions[ops] ret {
-        $ops.push_back($ret);
+        array_builder_append(&$ops, $ret, state->allocator);
         $$ = $ops;
     }
     | instructions
     ;
 
 instructions:
-    %empty { $$ = std::vector<Ast*>(); }
+    %empty { $$ = ArrayBuilder<AstId>{}; }
     | instructions instruction {
-        $1.push_back($instruction);
+        array_builder_append(&$1, $instruction, state->allocator);
         $$ = $1;
     }
     ;
@@ -197,28 +204,25 @@ instruction:
 ret:
     RET expression[expr] {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::RetStmt,
-            .ret_stmt = { $expr }
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            RetStmt{ $expr }
         );
     }
     | RET {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::RetStmt,
-            .ret_stmt = { nullptr }
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            RetStmt{ AST_NULL }
         );
     }
 
 builtinFunctionCall:
     IPT '(' variable[var] ')' {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::BuiltinFunction,
-            .builtin_function = {
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            BuiltinFunction{
                 .kind = BuiltinFunctionKind::Ipt,
                 .argument = $var,
             }
@@ -226,10 +230,9 @@ builtinFunctionCall:
     }
     | SHW '(' expression[expr] ')' {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::BuiltinFunction,
-            .builtin_function = {
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            BuiltinFunction{
                .kind = BuiltinFunctionKind::Shw,
                .argument = $expr,
             }
@@ -247,20 +250,19 @@ expression:
 variable:
     IDENTIFIER {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::VariableReference,
-            .variable_reference = {
-                .name = string_create($1, state->allocator),
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            VariableReference{
+                .name = intern($1),
+                .symbol = SYMBOL_NONE,
             }
         );
     }
     | variable[var] OSQUAREB expression[index] CSQUAREB {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @var.begin.line),
-            AstKind::IndexExpression,
-            .index_expression = {
+            &state->asts,
+            location_create(state->curr_file, @var.begin.line),
+            IndexExpression{
                 .element = $var,
                 .index = $index,
             }
@@ -309,19 +311,19 @@ booleanOperation:
         $$ = new_boolean_operation(state, $lhs, $rhs, BooleanOperationKind::Xor, @1.begin.line);
     }
     | NOT'('booleanOperation[op]')' {
-        $$ = new_boolean_operation(state, $op, nullptr, BooleanOperationKind::Not, @1.begin.line);
+        $$ = new_boolean_operation(state, $op, AST_NULL, BooleanOperationKind::Not, @1.begin.line);
     }
     ;
 
 functionCall:
     IDENTIFIER[name]'('parameterList[args]')' {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @name.begin.line),
-            AstKind::FunctionCall,
-            .function_call = {
-                .name = string_create($name, state->allocator),
-                .arguments = array_create_from_std_vector($args, state->allocator),
+            &state->asts,
+            location_create(state->curr_file, @name.begin.line),
+            FunctionCall{
+                .name = intern($name),
+                .arguments = ast_list_create($args, state->allocator),
+                .symbol = SYMBOL_NONE,
             }
         );
     }
@@ -330,24 +332,24 @@ functionCall:
 variableDefinition:
     type[t] IDENTIFIER[name] {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @name.begin.line),
-            AstKind::VariableDefinition,
-            .variable_definition = {
+            &state->asts,
+            location_create(state->curr_file, @name.begin.line),
+            VariableDefinition{
                 .type_specifier = $t,
-                .name = string_create($name, state->allocator),
+                .name = intern($name),
+                .symbol = SYMBOL_NONE,
             }
         );
     }
     | type[t] IDENTIFIER[name] OSQUAREB INT[size] CSQUAREB {
         $t.size = $size;
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @name.begin.line),
-            AstKind::VariableDefinition,
-            .variable_definition = {
+            &state->asts,
+            location_create(state->curr_file, @name.begin.line),
+            VariableDefinition{
                 .type_specifier = $t,
-                .name = string_create($name, state->allocator),
+                .name = intern($name),
+                .symbol = SYMBOL_NONE,
             }
         );
     }
@@ -356,10 +358,9 @@ variableDefinition:
 assignment:
     MOV'('variable[var] COMMA expression[expr]')' {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::Assignment,
-            .assignment = Assignment{ $var, $expr }
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            Assignment{ $var, $expr }
         );
     }
     ;
@@ -368,7 +369,7 @@ value:
     INT { $$ = new_value<long>(state, (long)$1, @1.begin.line); }
     | FLT { $$ = new_value<double>(state, $1, @1.begin.line); }
     | CHR { $$ = new_value<char>(state, $1, @1.begin.line); }
-    | STRING { $$ = new_value<std::string>(state, $1, @1.begin.line); }
+    | STRING { $$ = new_value<std::string_view>(state, $1, @1.begin.line); }
     ;
 
 controlStructure: cnd | for | whl;
@@ -376,10 +377,9 @@ controlStructure: cnd | for | whl;
 cnd:
     CND  booleanOperation[cond] BGN cndContent[cc] END {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::CndStmt,
-            .cnd_stmt = {
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            CndStmt{
                 .condition = $cond,
                 .block = $cc.block,
                 .otw = $cc.otw,
@@ -391,10 +391,9 @@ cnd:
 cndContent:
     code optOtw {
         auto block = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::Block,
-            .block = { array_create_from_std_vector($1, state->allocator) }
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            Block{ ast_list_create($1, state->allocator) }
         );
         $$ = CndContent{
             .block = block,
@@ -404,13 +403,12 @@ cndContent:
     ;
 
 optOtw:
-    %empty { $$ = nullptr; }
+    %empty { $$ = AST_NULL; }
     | OTW booleanOperation[cond] cndContent[cc] {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::CndStmt,
-            .cnd_stmt = {
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            CndStmt{
                 .condition = $cond,
                 .block = $cc.block,
                 .otw = $cc.otw,
@@ -419,10 +417,9 @@ optOtw:
     }
     | OTW code {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::Block,
-            .block { array_create_from_std_vector($2, state->allocator) }
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            Block{ ast_list_create($2, state->allocator) }
         );
     }
     ;
@@ -430,18 +427,16 @@ optOtw:
 for:
     FOR assignment[i] SEMI booleanOperation[c] SEMI expression[s] block[ops] {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::ForStmt,
-            .for_stmt = {
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            ForStmt{
                 .init = $i,
                 .condition = $c,
                 .step = new_ast(
-                    &state->ast_pool,
-                    location_create(state->curr_filename, @s.begin.line),
-                    AstKind::Assignment,
-                    .assignment = {
-                        .target = $i->data.assignment.target,
+                    &state->asts,
+                    location_create(state->curr_file, @s.begin.line),
+                    Assignment{
+                        .target = ast_get<Assignment>(&state->asts, $i).target,
                         .value = $s,
                     }
                 ),
@@ -454,10 +449,9 @@ for:
 whl:
     WHL booleanOperation[cond] block[ops] {
         $$ = new_ast(
-            &state->ast_pool,
-            location_create(state->curr_filename, @1.begin.line),
-            AstKind::WhlStmt,
-            .whl_stmt = {
+            &state->asts,
+            location_create(state->curr_file, @1.begin.line),
+            WhlStmt{
                 .condition = $cond,
                 .block = $ops,
             }
@@ -468,6 +462,6 @@ whl:
 
 void parser::Parser::error(const location_type& loc, const std::string& msg) {
     std::ostringstream oss;
-    oss << state->curr_filename << ":" << loc.begin.line << ": " << msg << "." << std::endl;
+    oss << intern_lookup(state->curr_file).view() << ":" << loc.begin.line << ": " << msg << "." << std::endl;
     msg::error(oss.str());
 }
@@ -1,14 +1,71 @@
 #include "preprocessor.hpp"
+#include "module.hpp"
 #include <algorithm>
+#include <fcntl.h>
 #include <filesystem>
-#include <regex>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Read only mapping of a source file (the lines are scanned in place).
+ */
+class MappedFile {
+      public:
+        MappedFile(std::string const &fileName) {
+            int fd = open(fileName.c_str(), O_RDONLY);
+            struct stat st;
+
+            if (fd < 0) {
+                return;
+            }
+            if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+                opened = true;
+                size = (size_t)st.st_size;
+            }
+            if (opened && size > 0) {
+                void *mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mem == MAP_FAILED) {
+                    opened = false;
+                    size = 0;
+                } else {
+                    data = (char const *)mem;
+                }
+            }
+            close(fd);
+        }
+        ~MappedFile() {
+            if (data != nullptr) {
+                munmap((void *)data, size);
+            }
+        }
+        MappedFile(MappedFile const &) = delete;
+        MappedFile &operator=(MappedFile const &) = delete;
+
+        bool opened = false;
+        char const *data = nullptr;
+        size_t size = 0;
+};
+
+static bool startsWith(char const *begin, char const *end, char const *prefix,
+                       size_t prefixSize) {
+    return (size_t)(end - begin) >= prefixSize &&
+           std::equal(prefix, prefix + prefixSize, begin);
+}
+
+// the previous implementation used regexes where `.` does not match '\r'
+static bool hasCarriageReturn(char const *begin, char const *end) {
+    return std::find(begin, end, '\r') != end;
+}
 
 /**
  * @brief  Get the path to the project and launch the preprocessor.
  *
  * @param  pathToMain  Just the path to the file given to the transpiler.
  */
-void Preprocessor::process(std::string pathToMain) {
+void Preprocessor::process(std::string pathToMain, std::string moduleDirectory) {
+    this->moduleDirectory = moduleDirectory;
     auto path = std::filesystem::path(pathToMain);
     pathToProject =
         std::filesystem::path(pathToMain).parent_path().string();
@@ -20,61 +77,86 @@ void Preprocessor::process(std::string pathToMain) {
 
 /**
  * @brief  Follow all the includes statemnents in the file and write all the
- *         code in one file that will be parsed and transpiled.
+ *         code in the output buffer that will be parsed and transpiled.
  *
  * @param  fileName  Name of the file to process.
  */
 void Preprocessor::process_rec(std::string fileName) {
     int lineCount = 1;
-    std::string line;
-    std::string includedFileName;
-    std::regex includeStmt("^use .+$");
-    std::regex fileIndicator("-->.*");
-    std::ifstream currentFile;
+    MappedFile currentFile(fileName);
 
-    // close the previously opened file (recursive call)
-    filesStack.push_back(fileName);
-    currentFile.open(fileName);
-
-    if (!currentFile.is_open()) {
+    if (!currentFile.opened) {
         std::ostringstream oss;
         oss << fileName << " doesn't exist.";
         throw std::logic_error(oss.str());
     }
+    filesStack.insert(fileName);
+
+    // the main file is not a module
+    size_t usedFileIdx = usedFilesList.size();
+    if (filesStack.size() > 1) {
+        UsedFile usedFile = {
+            .fileName = fileName,
+            .hash = module_hash(currentFile.data, currentFile.size),
+            .hasUse = false,
+            .interfaceFile = "",
+        };
+        if (!moduleDirectory.empty()) {
+            auto interfaceFile = module_interface_filename(moduleDirectory, usedFile.hash);
+            if (std::filesystem::exists(interfaceFile)) {
+                // the declarations are loaded from the interface by the parser
+                usedFile.interfaceFile = interfaceFile;
+                usedFilesList.push_back(usedFile);
+                filesStack.erase(fileName);
+                treatedFiles.insert(fileName);
+                return;
+            }
+        }
+        usedFilesList.push_back(usedFile);
+    }
 
     // file indicator for the parser
-    outputFile << "-->" << fileName << "-0" << std::endl;
+    outputBuffer += "-->" + fileName + "-0\n";
+
+    char const *end = currentFile.data + currentFile.size;
+    for (char const *line = currentFile.data; line < end;) {
+        char const *lineEnd = std::find(line, end, '\n');
 
-    while (std::getline(currentFile, line)) {
         // if the user tries to add a file indicator, we make
         // sure that the program is not parsed
-        if (std::regex_match(line, fileIndicator)) {
+        if (startsWith(line, lineEnd, "-->", 3) &&
+            !hasCarriageReturn(line + 3, lineEnd)) {
             std::ostringstream oss;
             oss << fileName << "(" << lineCount << ":0): synctax error.";
             throw std::logic_error(oss.str());
         }
-        // search for include statement
-        if (std::regex_match(line, includeStmt)) {
-            includedFileName = pathToProject + line.substr(4) + ".3";
-            bool isTreated = std::find(treatedFiles.begin(), treatedFiles.end(),
-                                       includedFileName) != treatedFiles.end();
-            bool isInStack = std::find(filesStack.begin(), filesStack.end(),
-                                       includedFileName) != filesStack.end();
-            if (!isTreated && !isInStack) {
+        // search for include statement (`use <file>`)
+        if (startsWith(line, lineEnd, "use ", 4) && lineEnd - line > 4 &&
+            !hasCarriageReturn(line + 4, lineEnd)) {
+            std::string includedFileName =
+                pathToProject + std::string(line + 4, lineEnd) + ".3";
+            if (usedFileIdx < usedFilesList.size()) {
+                usedFilesList[usedFileIdx].hasUse = true;
+            }
+            if (!treatedFiles.count(includedFileName) &&
+                !filesStack.count(includedFileName)) {
                 // treat the file
+                size_t outputSize = outputBuffer.size();
                 process_rec(includedFileName);
-                outputFile << "-->" << fileName << "-" << (lineCount - 1)
-                           << std::endl;
+                if (outputBuffer.size() != outputSize) {
+                    outputBuffer += "-->" + fileName + "-" +
+                                    std::to_string(lineCount - 1) + "\n";
+                }
             }
-            outputFile << "~~~ " << line << std::endl;
-        } else {
-            // put the line in the output file
-            outputFile << line << std::endl;
+            outputBuffer += "~~~ ";
         }
+        // put the line in the output buffer
+        outputBuffer.append(line, lineEnd);
+        outputBuffer += '\n';
+        line = lineEnd + 1;
         lineCount++;
     }
     // when it's done, the file is considered as treated
-    treatedFiles.push_back(filesStack.back());
-    filesStack.pop_back();
-    currentFile.close();
+    filesStack.erase(fileName);
+    treatedFiles.insert(fileName);
 }
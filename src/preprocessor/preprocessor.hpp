@@ -1,7 +1,8 @@
 #ifndef PREPROCESSOR_H
 #define PREPROCESSOR_H
-#include <fstream>
 #include <string>
+#include <cstdint>
+#include <unordered_set>
 #include <vector>
 
 /*
@@ -9,19 +10,36 @@
  * from the begining after each include.
  */
 
+/*
+ * File included with `use`.
+ */
+struct UsedFile {
+        std::string fileName;
+        uint64_t hash;
+        bool hasUse; // the file uses other files
+        // module interface loaded instead of the file (empty if the file is
+        // included in the output)
+        std::string interfaceFile;
+};
+
 class Preprocessor {
       public:
         void process_rec(std::string fileName);
-        void process(std::string pathToMain);
-        Preprocessor(std::string outputFileName)
-            : outputFile(std::ofstream(outputFileName)) {}
+        // the module interfaces are looked up in moduleDirectory (disabled
+        // when empty)
+        void process(std::string pathToMain, std::string moduleDirectory = "");
+        std::string const &output() const { return outputBuffer; }
+        std::vector<UsedFile> const &usedFiles() const { return usedFilesList; }
+        Preprocessor() = default;
         ~Preprocessor() = default;
 
       private:
-        std::vector<std::string> treatedFiles;
-        std::vector<std::string> filesStack;
-        std::ofstream outputFile;
+        std::unordered_set<std::string> treatedFiles;
+        std::unordered_set<std::string> filesStack; // files being processed
+        std::vector<UsedFile> usedFilesList;
+        std::string outputBuffer;
         std::string pathToProject;
+        std::string moduleDirectory;
 };
 
 #endif
@@ -5,8 +5,11 @@
 #include <vector>
 
 struct Program {
-    std::vector<Ast *> code;
+    AstStorage const *asts;
+    std::vector<AstId> code;
     Scope *scope;
+    std::vector<Type *> const *expr_types; // indexed by the ast ids
+    std::vector<Symbol> const *symbols;    // indexed by the symbol ids
 };
 
 #endif
@@ -0,0 +1,202 @@
+#include "resolve.hpp"
+#include "tools/messages.hpp"
+#include "tools/time_report.hpp"
+
+void resolve(ResolveState *state, AstId ast, Scope *scope);
+
+Type *type_specifier_to_type(ResolveState *state, Scope *scope, TypeSpecifier const &specifier) {
+    Type *type = nullptr;
+
+    switch (specifier.kind) {
+    case TypeSpecifierKind::Nil: type = type_nil(state->types); break;
+    case TypeSpecifierKind::Chr: type = type_primitive(state->types, PrimitiveType::Chr); break;
+    case TypeSpecifierKind::Int: type = type_primitive(state->types, PrimitiveType::Int); break;
+    case TypeSpecifierKind::Flt: type = type_primitive(state->types, PrimitiveType::Flt); break;
+    case TypeSpecifierKind::Str: type = type_primitive(state->types, PrimitiveType::Str); break;
+    case TypeSpecifierKind::Obj: type = scope_lookup_type(scope, specifier.name)->type; break;
+    }
+
+    // TODO: update this when we will support dynamic arrays
+    if (specifier.size > 0) {
+        return intern_type(
+            state->types,
+            TypeKind::Array,
+            .array = {
+                .element_type = type,
+                .size = specifier.size,
+                .dynamic = false,
+            },
+        );
+    }
+    return type;
+}
+
+void resolve_variable_definition(ResolveState *state, AstId ast, Scope *scope) {
+    auto &definition = ast_get<VariableDefinition>(state->asts, ast);
+    SymbolId symbol = scope_find_symbol(scope, definition.name);
+
+    if (symbol == SYMBOL_NONE) {
+        Type *type = type_specifier_to_type(state, scope, definition.type_specifier);
+        symbol = scope_add_symbol(scope, state->symbols, definition.name, type,
+                                  ast, ast_location(state->asts, ast));
+    }
+    definition.symbol = symbol;
+}
+
+void resolve_block(ResolveState *state, AstId ast, Scope *scope) {
+    Scope *block_scope = scope_add_child(scope, ast);
+    for (AstId instruction : ast_get<Block>(state->asts, ast).asts) {
+        resolve(state, instruction, block_scope);
+    }
+}
+
+void resolve_function_definition(ResolveState *state, AstId ast, Scope *scope) {
+    auto const &function = ast_get<Function>(state->asts, ast);
+    Scope *function_scope = scope_add_child(scope, ast);
+
+    for (AstId argument : function.arguments) {
+        resolve_variable_definition(state, argument, function_scope);
+    }
+    resolve_block(state, function.body, function_scope);
+}
+
+void resolve_function_call(ResolveState *state, AstId ast, Scope *scope) {
+    auto &call = ast_get<FunctionCall>(state->asts, ast);
+
+    call.symbol = scope_lookup_symbol(scope, call.name);
+    for (AstId argument : call.arguments) {
+        resolve(state, argument, scope);
+    }
+}
+
+// The scopes are the same as the ones used by the checker before: the
+// conditions and the loops have their own scope, and their blocks are
+// children of this scope.
+void resolve(ResolveState *state, AstId ast, Scope *scope) {
+    if (ast == AST_NULL) {
+        return;
+    }
+
+    switch (ast_kind(state->asts, ast)) {
+    case AstKind::Value:
+        break;
+    case AstKind::VariableDefinition:
+        resolve_variable_definition(state, ast, scope);
+        break;
+    case AstKind::VariableReference: {
+        auto &reference = ast_get<VariableReference>(state->asts, ast);
+        reference.symbol = scope_lookup_symbol(scope, reference.name);
+    } break;
+    case AstKind::Assignment: {
+        auto const &assignment = ast_get<Assignment>(state->asts, ast);
+        resolve(state, assignment.value, scope);
+        resolve(state, assignment.target, scope);
+    } break;
+    case AstKind::IndexExpression: {
+        auto const &expression = ast_get<IndexExpression>(state->asts, ast);
+        resolve(state, expression.element, scope);
+        resolve(state, expression.index, scope);
+    } break;
+    case AstKind::Function:
+        if (ast_get<Function>(state->asts, ast).body != AST_NULL) {
+            resolve_function_definition(state, ast, scope);
+        }
+        break;
+    case AstKind::FunctionCall:
+        resolve_function_call(state, ast, scope);
+        break;
+    case AstKind::CndStmt: {
+        auto const &cnd_stmt = ast_get<CndStmt>(state->asts, ast);
+        Scope *cnd_scope = scope_add_child(scope, ast);
+        resolve(state, cnd_stmt.condition, cnd_scope);
+        resolve_block(state, cnd_stmt.block, cnd_scope);
+        resolve(state, cnd_stmt.otw, scope);
+    } break;
+    case AstKind::WhlStmt: {
+        auto const &whl_stmt = ast_get<WhlStmt>(state->asts, ast);
+        Scope *whl_scope = scope_add_child(scope, ast);
+        resolve(state, whl_stmt.condition, whl_scope);
+        resolve_block(state, whl_stmt.block, whl_scope);
+    } break;
+    case AstKind::ForStmt: {
+        auto const &for_stmt = ast_get<ForStmt>(state->asts, ast);
+        Scope *for_scope = scope_add_child(scope, ast);
+        resolve(state, for_stmt.init, for_scope);
+        resolve(state, for_stmt.condition, for_scope);
+        resolve(state, for_stmt.step, for_scope);
+        resolve_block(state, for_stmt.block, for_scope);
+    } break;
+    case AstKind::RetStmt:
+        resolve(state, ast_get<RetStmt>(state->asts, ast).expression, scope);
+        break;
+    case AstKind::Block:
+        resolve_block(state, ast, scope);
+        break;
+    case AstKind::ArithmeticOperation: {
+        auto const &operation = ast_get<ArithmeticOperation>(state->asts, ast);
+        resolve(state, operation.lhs, scope);
+        resolve(state, operation.rhs, scope);
+    } break;
+    case AstKind::BooleanOperation: {
+        auto const &operation = ast_get<BooleanOperation>(state->asts, ast);
+        resolve(state, operation.lhs, scope);
+        resolve(state, operation.rhs, scope);
+    } break;
+    case AstKind::BuiltinFunction:
+        resolve(state, ast_get<BuiltinFunction>(state->asts, ast).argument, scope);
+        break;
+    }
+}
+
+Type *function_type_from_ast(ResolveState *state, Scope *scope, AstId ast) {
+    auto const &function = ast_get<Function>(state->asts, ast);
+    Type *return_type = type_specifier_to_type(state, scope, function.return_type_specifier);
+    size_t nb_args = function.arguments.len;
+    Array<Type *> arguments_types = array_create<Type *>(nb_args, nb_args, state->allocator);
+
+    for (size_t i = 0; i < function.arguments.len; ++i) {
+        AstId arg = function.arguments[i];
+        arguments_types[i] = type_specifier_to_type(
+            state, scope,
+            ast_get<VariableDefinition>(state->asts, arg).type_specifier);
+    }
+    return intern_type(
+        state->types,
+        TypeKind::Function,
+        .function = {
+            .return_type = return_type,
+            .arguments_types = arguments_types,
+        }
+    );
+}
+
+// First pass in which global symbols are added to the symbol table.
+bool process_global_symbols(ResolveState *state, std::vector<AstId> const &program, Scope *global_scope) {
+    for (AstId ast : program) {
+        Location const &location = ast_location(state->asts, ast);
+        auto &function = ast_get<Function>(state->asts, ast);
+        SymbolId symbol = scope_find_symbol(global_scope, function.name);
+
+        if (symbol != SYMBOL_NONE) {
+            MULTIPLE_DEFINITION_ERROR(location, function.name.ptr,
+                                      (*state->symbols)[symbol].location);
+            return false;
+        }
+        Type *function_type = function_type_from_ast(state, global_scope, ast);
+        function.symbol = scope_add_symbol(global_scope, state->symbols, function.name,
+                                           function_type, ast, location);
+    }
+    return true;
+}
+
+bool resolve(ResolveState *state, std::vector<AstId> const &program) {
+    PhaseTimer timer(Phase::Resolve);
+
+    if (!process_global_symbols(state, program, state->global_scope)) {
+        return false;
+    }
+    for (AstId ast : program) {
+        resolve(state, ast, state->global_scope);
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef RESOLVE
+#define RESOLVE
+#include "ast.hpp"
+#include "scope.hpp"
+#include "type.hpp"
+#include "tools/mem.hpp"
+#include <vector>
+
+/*
+ * Name resolution pass (run after the parsing). It creates the scopes and the
+ * symbols of the program and binds each definition, reference and call to its
+ * symbol, so the checker and the backend never look up a name.
+ *
+ * The only errors reported here are the multiple definitions of the global
+ * functions. The unresolved names are bound to SYMBOL_NONE and the variables
+ * defined twice in a scope are bound to the first definition, the checker
+ * reports them in the order of the program.
+ */
+
+struct ResolveState {
+    AstStorage *asts;
+    TypeTable *types;
+    Allocator allocator;
+    Scope *global_scope;
+    std::vector<Symbol> *symbols;
+};
+
+bool resolve(ResolveState *state, std::vector<AstId> const &program);
+
+#endif
@@ -3,18 +3,16 @@
 #include "tools/messages.hpp"
 #include "ast.hpp"
 #include "type.hpp"
-#include "type.hpp"
 #include <sstream>
 
-// create type table entries for the builtin types
-// Note: doing this avoid allocating multiple pointers to the same primitive
-// type. It is also more coherent
+// create type table entries for the builtin types (the types are the unique
+// instances of the type table)
 void init_global_scope(State *state) {
-    scope_add_type(state->global_scope, "nil", new_type(&state->type_pool, TypeKind::Nil, {}));
-    scope_add_type(state->global_scope, "chr", new_type(&state->type_pool, TypeKind::Primitive, .primitive = PrimitiveType::Chr));
-    scope_add_type(state->global_scope, "int", new_type(&state->type_pool, TypeKind::Primitive, .primitive = PrimitiveType::Int));
-    scope_add_type(state->global_scope, "flt", new_type(&state->type_pool, TypeKind::Primitive, .primitive = PrimitiveType::Flt));
-    scope_add_type(state->global_scope, "str", new_type(&state->type_pool, TypeKind::Primitive, .primitive = PrimitiveType::Str));
+    scope_add_type(state->global_scope, intern("nil"), type_nil(&state->types));
+    scope_add_type(state->global_scope, intern("chr"), type_primitive(&state->types, PrimitiveType::Chr));
+    scope_add_type(state->global_scope, intern("int"), type_primitive(&state->types, PrimitiveType::Int));
+    scope_add_type(state->global_scope, intern("flt"), type_primitive(&state->types, PrimitiveType::Flt));
+    scope_add_type(state->global_scope, intern("str"), type_primitive(&state->types, PrimitiveType::Str));
 }
 
 State *state_create() {
@@ -23,54 +21,75 @@ State *state_create() {
     state->status = 0;
     state->arena = arena_create();
     state->allocator = arena_allocator(&state->arena);
-    // TODO: use the default pool size (should be a define)
-    mem_pool_init(&state->ast_pool, 100);
-    mem_pool_init(&state->type_pool, 100);
+    tracking_allocator_init(&state->tracking, state->allocator);
+    type_table_init(&state->types);
     init_global_scope(state);
     return state;
 }
 
 void state_destroy(State *state) {
     scope_destroy(state->global_scope);
-    mem_pool_destroy(&state->ast_pool);
-    mem_pool_destroy(&state->type_pool);
+    type_table_destroy(&state->types);
     arena_destroy(&state->arena);
     delete state;
 }
 
-void enter_file(State *state, std::string const &filename) {
+// Clear the state so it can be used for another compilation. The memory of the
+// pools and of the arena is kept.
+void state_reset(State *state) {
+    scope_destroy(state->global_scope);
+    state->global_scope = scope_create();
+    state->status = 0;
+    state->curr_file = IDENTIFIER_EMPTY;
+    state->program.clear();
+    ast_storage_clear(&state->asts);
+    state->expr_types.clear();
+    state->symbols.resize(1);
+    type_table_reset(&state->types);
+    arena_reset(&state->arena);
+    tracking_allocator_clear(&state->tracking);
+    init_global_scope(state);
+}
+
+// Tracking the allocations of the state also tracks the arrays and the strings
+// of the ast and the allocations of the checker (they use the same allocator).
+void state_track_allocations(State *state, bool track) {
+    if (track) {
+        state->allocator = tracking_allocator(&state->tracking);
+    } else {
+        state->allocator = arena_allocator(&state->arena);
+    }
+}
+
+void enter_file(State *state, std::string_view filename) {
     if (filename.empty()) {
         return;
     }
 
-    state->curr_filename = filename[0] == '"' ? filename.substr(1) : filename;
-    if (filename.back() == '"') {
-        state->curr_filename.pop_back();
+    if (filename[0] == '"') {
+        filename.remove_prefix(1);
+    }
+    if (!filename.empty() && filename.back() == '"') {
+        filename.remove_suffix(1);
     }
+    state->curr_file = intern(filename).id;
 }
 
-void add_function(State *state, Ast *ast) {
+void add_function(State *state, AstId ast) {
     state->program.push_back(ast);
 }
 
-Ast *new_arithmetic_operation(State *state, Ast *lhs, Ast *rhs,
-                              ArithmeticOperationKind kind, size_t line) {
-    auto op_ast = new_ast(
-        &state->ast_pool,
-        LOCATION,
-        AstKind::ArithmeticOperation,
-        .arithmetic_operation = ArithmeticOperation{kind, lhs, rhs}
-    );
-    return op_ast;
+AstId new_arithmetic_operation(State *state, AstId lhs, AstId rhs,
+                               ArithmeticOperationKind kind, size_t line) {
+    return new_ast(&state->asts, LOCATION, ArithmeticOperation{kind, lhs, rhs});
 }
 
-Ast *new_boolean_operation(State *state, Ast *lhs, Ast *rhs,
-                           BooleanOperationKind kind, size_t line) {
+AstId new_boolean_operation(State *state, AstId lhs, AstId rhs,
+                            BooleanOperationKind kind, size_t line) {
     return new_ast(
-        &state->ast_pool,
-        location_create(state->curr_filename, line),
-        AstKind::BooleanOperation,
-        .boolean_operation = {
+        &state->asts,
+        location_create(state->curr_file, line),
+        BooleanOperation{
             .kind = kind,
             .lhs = lhs,
             .rhs = rhs,
@@ -79,11 +98,12 @@ Ast *new_boolean_operation(State *state, Ast *lhs, Ast *rhs,
 }
 
 bool try_verify_main_type(State *state) {
-    auto sym = scope_lookup_symbol(state->global_scope, "main");
+    SymbolId symbol = scope_lookup_symbol(state->global_scope, intern("main"));
 
-    if (!sym) {
+    if (symbol == SYMBOL_NONE) {
         return true; // when compiling libraries or object files
     }
+    Symbol const *sym = &state->symbols[symbol];
 
     if (sym->type->kind != TypeKind::Function) {
         ERROR(sym->location, "main should be a function.")
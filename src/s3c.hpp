@@ -7,69 +7,72 @@
 #include <cstring>
 #include <functional>
 #include <stack>
+#include <string_view>
 
-#define LOCATION location_create(state->curr_filename, line)
+#define LOCATION location_create(state->curr_file, line)
 
 struct State {
     int status;
-    std::string curr_filename;
+    IdentifierId curr_file;
     Scope *global_scope;
-    std::vector<Ast *> program;
-    MemPool<Ast> ast_pool;
-    MemPool<Type> type_pool;
+    std::vector<AstId> program;
+    AstStorage asts;
+    // types of the expressions indexed by the ast ids (filled by the checker)
+    std::vector<Type *> expr_types;
+    // symbols of the program indexed by the symbol ids (filled by the
+    // resolver, the first one is the placeholder of SYMBOL_NONE)
+    std::vector<Symbol> symbols = {Symbol{}};
+    TypeTable types;
     Arena arena;
     Allocator allocator;
+    // used instead of the arena allocator when the allocations are tracked
+    TrackingAllocator tracking;
 };
 
 State *state_create();
 void state_destroy(State *state);
+void state_reset(State *state);
+void state_track_allocations(State *state, bool track);
 
-void enter_file(State *state, std::string const &filename);
+void enter_file(State *state, std::string_view filename);
 
-void add_function(State *state, Ast *function);
+void add_function(State *state, AstId function);
 
-Ast *new_arithmetic_operation(State *state, Ast *lhs, Ast *rhs, ArithmeticOperationKind kind, size_t line);
-Ast *new_boolean_operation(State *state, Ast *lhs, Ast *rhs, BooleanOperationKind kind, size_t line);
+AstId new_arithmetic_operation(State *state, AstId lhs, AstId rhs, ArithmeticOperationKind kind, size_t line);
+AstId new_boolean_operation(State *state, AstId lhs, AstId rhs, BooleanOperationKind kind, size_t line);
 
 bool try_verify_main_type(State *state);
 
 template <typename T>
-Ast *new_value(State *state, T value, size_t line) {
-    Ast *ast = nullptr;
-    auto location = location_create(state->curr_filename, line);
+AstId new_value(State *state, T value, size_t line) {
+    auto location = location_create(state->curr_file, line);
+    Value node = {
+        .kind = ValueKind::Integer,
+        .value = { .integer = 0 },
+    };
 
     if constexpr (std::is_same_v<T, long>) {
-        ast = new_ast(&state->ast_pool, location, AstKind::Value,
-                        .value = Value{
-                            .kind = ValueKind::Integer,
-                            .value = { .integer = value },
-                        });
+        node = Value{
+            .kind = ValueKind::Integer,
+            .value = { .integer = value },
+        };
     } else if constexpr (std::is_same_v<T, double>) {
-        ast = new_ast(&state->ast_pool, location, AstKind::Value,
-                        .value = Value{
-                            .kind = ValueKind::Real,
-                            .value = { .real = value },
-                        });
+        node = Value{
+            .kind = ValueKind::Real,
+            .value = { .real = value },
+        };
     } else if constexpr (std::is_same_v<T, char>) {
-        ast = new_ast(&state->ast_pool, location, AstKind::Value,
-                        .value = Value{
-                            .kind = ValueKind::Character,
-                            .value = { .character = value },
-                        });
-    } else if constexpr (std::is_same_v<T, std::string>) {
-        ast = new_ast(&state->ast_pool, location, AstKind::Value,
-                        .value = Value{
-                            .kind = ValueKind::String,
-                            .value = { .string = string_create(value, state->allocator) },
-                        });
-    } else {
-        ast = new_ast(&state->ast_pool, location, AstKind::Value,
-                        .value = Value{
-                            .kind = ValueKind::Integer,
-                            .value = { .integer = 0 },
-                        });
+        node = Value{
+            .kind = ValueKind::Character,
+            .value = { .character = value },
+        };
+    } else if constexpr (std::is_same_v<T, std::string_view>) {
+        node = Value{
+            .kind = ValueKind::String,
+            .value = { .string = string_create(value, state->allocator) },
+        };
     }
-    return ast;
+    return new_ast(&state->asts, location, node);
 }
 
 #endif
@@ -1,71 +1,72 @@
 #include "scope.hpp"
+#include "tools/time_report.hpp"
 #include <algorithm>
 
 Scope *scope_create(Scope *parent) {
     auto scope = new Scope();
     scope->parent = parent;
+    time_report_count(Counter::Scopes);
     return scope;
 }
 
-// Since we use maps, we won't use an arena for the scope
+// Since the tables are vectors, we won't use an arena for the scope
 void scope_destroy(Scope *scope) {
-    for (auto &child : scope->child_scopes) {
-        scope_destroy(child.second);
-    }
+    hash_table_for_each(&scope->child_scopes, [](uint32_t, Scope *child) {
+        scope_destroy(child);
+    });
     delete scope;
 }
 
-Symbol *scope_add_symbol(Scope *scope, std::string const &name, Type *type, Location const &location) {
-    scope->symbol_table[name] = Symbol{
+SymbolId scope_add_symbol(Scope *scope, std::vector<Symbol> *symbols, Identifier name,
+                          Type *type, AstId ast, Location const &location) {
+    SymbolId id = (SymbolId)symbols->size();
+    symbols->push_back(Symbol{
         .type = type,
         .scope = scope,
+        .ast = ast,
         .location = location,
-    };
-    return &scope->symbol_table[name];
+    });
+    hash_table_get_or_insert(&scope->symbol_table, name.id) = id;
+    return id;
 }
 
-TypeInfo *scope_add_type(Scope *scope, std::string const &name, Type *type, Location const &location) {
-    scope->type_table[name] = TypeInfo{
+TypeInfo *scope_add_type(Scope *scope, Identifier name, Type *type, Location const &location) {
+    auto &type_info = hash_table_get_or_insert(&scope->type_table, name.id);
+    type_info = TypeInfo{
         .type = type,
         .scope = scope,
         .size = size_of(type),
         .location = location,
     };
-    return &scope->type_table[name];
+    return &type_info;
 }
 
-Scope *scope_add_child(Scope *scope, Ast *ast) {
+Scope *scope_add_child(Scope *scope, AstId ast) {
     auto child = scope_create(scope);
-    scope->child_scopes[ast] = child;
+    hash_table_get_or_insert(&scope->child_scopes, ast) = child;
     return child;
 }
 
-Symbol *scope_lookup_symbol(Scope *scope, std::string const &symbol_name) {
-    if (scope == nullptr) {
-        return nullptr;
-    }
-    if (map_contains(scope->symbol_table, symbol_name)) {
-        return &scope->symbol_table[symbol_name];
-    }
-    return scope_lookup_symbol(scope->parent, symbol_name);
+SymbolId scope_find_symbol(Scope *scope, Identifier symbol_name) {
+    SymbolId *id = hash_table_find(&scope->symbol_table, symbol_name.id);
+    return id ? *id : SYMBOL_NONE;
 }
 
-TypeInfo *scope_lookup_type(Scope *scope, std::string const &type_name) {
-    if (scope == nullptr) {
-        return nullptr;
-    }
-    if (map_contains(scope->type_table, type_name)) {
-        return &scope->type_table[type_name];
+// The lookups go up the scopes with one probe per scope.
+SymbolId scope_lookup_symbol(Scope *scope, Identifier symbol_name) {
+    for (; scope != nullptr; scope = scope->parent) {
+        if (SymbolId *id = hash_table_find(&scope->symbol_table, symbol_name.id)) {
+            return *id;
+        }
     }
-    return scope_lookup_type(scope->parent, type_name);
+    return SYMBOL_NONE;
 }
 
-Type *scope_lookup_expr_type(Scope *scope, Ast *expr) {
-    if (scope == nullptr) {
-        return nullptr;
-    }
-    if (map_contains(scope->expr_types, expr)) {
-        return scope->expr_types[expr];
+TypeInfo *scope_lookup_type(Scope *scope, Identifier type_name) {
+    for (; scope != nullptr; scope = scope->parent) {
+        if (TypeInfo *type_info = hash_table_find(&scope->type_table, type_name.id)) {
+            return type_info;
+        }
     }
-    return scope_lookup_expr_type(scope->parent, expr);
+    return nullptr;
 }
@@ -2,15 +2,18 @@
 #define SCOPE
 #include "ast.hpp"
 #include "type.hpp"
+#include "tools/hash_table.hpp"
+#include "tools/intern.hpp"
 #include "tools/mem.hpp"
-#include <map>
 #include <string>
+#include <vector>
 
 struct Scope;
 
 struct Symbol {
     Type *type;
     Scope *scope;
+    AstId ast; // definition
     Location location;
 };
 
@@ -21,12 +24,15 @@ struct TypeInfo {
     Location location; // empty for primitive types
 };
 
+// The tables are keyed by the interned identifiers and by the ast ids (see
+// tools/hash_table.hpp). The symbols are stored in a dense array shared by all
+// the scopes of the program (indexed by the symbol ids, the first element is
+// a placeholder for SYMBOL_NONE), so the ids stay valid when symbols are added.
 struct Scope {
     Scope *parent;
-    std::map<Ast*, Scope*> child_scopes;        // childs scopes indexed by ast nodes (blocks and functions nodes)
-    std::map<std::string, Symbol> symbol_table; // table of symbls
-    std::map<std::string, TypeInfo> type_table; // table of types (obj, enm, uni)
-    std::map<Ast*, Type*> expr_types;           // evaluated types of expressions (filled during type checking)
+    HashTable<Scope*> child_scopes;     // childs scopes indexed by ast nodes (blocks and functions nodes)
+    HashTable<SymbolId> symbol_table;   // table of symbls
+    HashTable<TypeInfo> type_table;     // table of types (obj, enm, uni)
 };
 
 // TODO: we should init the first scope in s3c.cpp, adding primitive types infos
@@ -34,20 +40,14 @@ struct Scope {
 Scope *scope_create(Scope *parent = nullptr);
 void scope_destroy(Scope *scope);
 
-Symbol   *scope_add_symbol(Scope *scope, std::string const &name, Type *type, Location const &location);
-TypeInfo *scope_add_type(Scope *scope, std::string const &name, Type *type, Location const &location = {});
+SymbolId  scope_add_symbol(Scope *scope, std::vector<Symbol> *symbols, Identifier name,
+                           Type *type, AstId ast, Location const &location);
+TypeInfo *scope_add_type(Scope *scope, Identifier name, Type *type, Location const &location = {});
 
-Scope  *scope_add_child(Scope *scope, Ast *ast);
+Scope  *scope_add_child(Scope *scope, AstId ast);
 
-Symbol   *scope_lookup_symbol(Scope *scope, std::string const &symbol_name);
-TypeInfo *scope_lookup_type(Scope *scope, std::string const &type_name);
-Type     *scope_lookup_expr_type(Scope *scope, Ast *expr);
-
-// contains helper function for maps (the contains method was added in C++20,
-// but the project uses C++17)
-template <typename K, typename V>
-bool map_contains(std::map<K, V> const &m, K const &key) {
-    return m.find(key) != m.end();
-}
+SymbolId  scope_find_symbol(Scope *scope, Identifier symbol_name); // only in this scope
+SymbolId  scope_lookup_symbol(Scope *scope, Identifier symbol_name);
+TypeInfo *scope_lookup_type(Scope *scope, Identifier type_name);
 
 #endif
@@ -1,6 +1,8 @@
 #ifndef TOOLS_ARRAY
 #define TOOLS_ARRAY
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <vector>
 #include <cstring>
 #include "mem.hpp"
@@ -52,19 +54,82 @@ void array_destroy(Array<T> *array) {
     free(array->allocator, array->ptr);
 }
 
+// Grow the capacity to at least `cap` elements. With the arena allocator, the
+// buffer is grown in place when it is the last allocation of the arena.
 template <typename T>
-void array_append(Array<T> *array, T const &elt) {
-    if (array->len + 1 >= array->cap) {
-        array->cap = std::max(array->cap * 2, (size_t)1);
-        T *ptr = alloc<T>(array->allocator, array->cap);
-        memmove(ptr, array->ptr, array->len * sizeof(T));
+void array_reserve(Array<T> *array, size_t cap) {
+    if (cap <= array->cap) {
+        return;
+    }
+    array->ptr = (T*)resize(array->allocator, array->ptr,
+                            array->cap * sizeof(T), cap * sizeof(T));
+    assert(array->ptr != nullptr && "error: failed to allocate array.");
+    array->cap = cap;
+}
+
+// Give back the unused capacity (used once an array is built, in place with
+// the arena allocator when possible).
+template <typename T>
+void array_shrink_to_fit(Array<T> *array) {
+    if (array->len == array->cap) {
+        return;
+    }
+    if (array->len == 0) {
         free(array->allocator, array->ptr);
-        array->ptr = ptr;
+        array->ptr = nullptr;
+    } else {
+        array->ptr = (T*)resize(array->allocator, array->ptr,
+                                array->cap * sizeof(T), array->len * sizeof(T));
+    }
+    array->cap = array->len;
+}
+
+template <typename T>
+void array_append(Array<T> *array, T const &elt) {
+    if (array->len == array->cap) {
+        array_reserve(array, std::max(array->cap * 2, (size_t)4));
     }
     array->ptr[array->len] = elt;
     array->len += 1;
 }
 
+/*
+ * Small array used by the parser to build the arrays of the asts (its size
+ * matters since it is stored in the parser stack, so the allocator is given to
+ * each operation). The result has the exact size.
+ */
+template <typename T>
+struct ArrayBuilder {
+    T *ptr;
+    uint32_t len;
+    uint32_t cap;
+};
+
+template <typename T>
+void array_builder_append(ArrayBuilder<T> *builder, T const &elt, Allocator allocator) {
+    if (builder->len == builder->cap) {
+        uint32_t cap = std::max(builder->cap * 2, (uint32_t)4);
+        builder->ptr = (T*)resize(allocator, builder->ptr,
+                                  builder->cap * sizeof(T), cap * sizeof(T));
+        assert(builder->ptr != nullptr && "error: failed to allocate array.");
+        builder->cap = cap;
+    }
+    builder->ptr[builder->len] = elt;
+    builder->len += 1;
+}
+
+template <typename T>
+Array<T> array_builder_finish(ArrayBuilder<T> builder, Allocator allocator) {
+    Array<T> array = {
+        .ptr = builder.ptr,
+        .len = builder.len,
+        .cap = builder.cap,
+        .allocator = allocator,
+    };
+    array_shrink_to_fit(&array);
+    return array;
+}
+
 template <typename T>
 Array<T> array_create_from_std_vector(std::vector<T> const &vector, Allocator allocator = DEFAULT_ALLOCATOR) {
     Array<T> array = array_create<T>(vector.size(), vector.size(), allocator);
@@ -0,0 +1,37 @@
+#ifndef TOOLS_HASH
+#define TOOLS_HASH
+#include <cstddef>
+#include <cstdint>
+
+#define HASH_FNV1A_OFFSET 0xcbf29ce484222325ull
+#define HASH_FNV1A_PRIME 0x100000001b3ull
+
+/*
+ * 64 bits FNV-1a hash. The result only depends on the bytes (not on the
+ * platform or on the run), so it can be used to identify data across
+ * compilations. The seed can be used to chain the hash of multiple buffers.
+ */
+inline uint64_t hash_bytes(void const *data, size_t size,
+                           uint64_t seed = HASH_FNV1A_OFFSET) {
+    auto bytes = (uint8_t const *)data;
+    uint64_t hash = seed;
+
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= HASH_FNV1A_PRIME;
+    }
+    return hash;
+}
+
+// Mix the bits of a 32 bits key (used to index the hash tables, the ids are
+// small consecutive integers).
+inline uint32_t hash_u32(uint32_t key) {
+    key ^= key >> 16;
+    key *= 0x7feb352du;
+    key ^= key >> 15;
+    key *= 0x846ca68bu;
+    key ^= key >> 16;
+    return key;
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef TOOLS_HASH_TABLE
+#define TOOLS_HASH_TABLE
+#include "tools/hash.hpp"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Open addressing hash table (linear probing) for 32 bits keys (identifier
+ * ids and ast ids). The key 0 is used to mark the free slots, which is fine
+ * since it is the id of the empty identifier and of the null ast. The entries
+ * are stored inline, so a lookup is a single probe sequence in one array.
+ *
+ * Note: the pointers to the values are invalidated when a key is added.
+ */
+
+#define HASH_TABLE_EMPTY_KEY 0
+#define HASH_TABLE_MIN_CAPACITY 8
+
+template <typename V>
+struct HashTableEntry {
+    uint32_t key;
+    V value;
+};
+
+template <typename V>
+struct HashTable {
+    std::vector<HashTableEntry<V>> entries; // capacity is a power of 2
+    uint32_t len = 0;
+};
+
+template <typename V>
+size_t hash_table_slot(HashTable<V> const *table, uint32_t key) {
+    size_t mask = table->entries.size() - 1;
+    size_t idx = hash_u32(key) & mask;
+
+    while (table->entries[idx].key != key &&
+           table->entries[idx].key != HASH_TABLE_EMPTY_KEY) {
+        idx = (idx + 1) & mask;
+    }
+    return idx;
+}
+
+template <typename V>
+V *hash_table_find(HashTable<V> *table, uint32_t key) {
+    assert(key != HASH_TABLE_EMPTY_KEY);
+    if (table->len == 0) {
+        return nullptr;
+    }
+    auto &entry = table->entries[hash_table_slot(table, key)];
+    return entry.key == key ? &entry.value : nullptr;
+}
+
+template <typename V>
+V const *hash_table_find(HashTable<V> const *table, uint32_t key) {
+    return hash_table_find(const_cast<HashTable<V> *>(table), key);
+}
+
+template <typename V>
+void hash_table_grow(HashTable<V> *table) {
+    size_t capacity = table->entries.empty() ? HASH_TABLE_MIN_CAPACITY
+                                             : 2 * table->entries.size();
+    std::vector<HashTableEntry<V>> entries(capacity);
+
+    std::swap(entries, table->entries);
+    for (auto &entry : entries) {
+        if (entry.key != HASH_TABLE_EMPTY_KEY) {
+            table->entries[hash_table_slot(table, entry.key)] = entry;
+        }
+    }
+}
+
+// Returns the value of the key, a value initialized entry is created if the
+// key is not in the table.
+template <typename V>
+V &hash_table_get_or_insert(HashTable<V> *table, uint32_t key) {
+    assert(key != HASH_TABLE_EMPTY_KEY);
+    // the load factor is kept under 1/2 (the lookups that go up the scopes
+    // mostly miss, and the misses are expensive with linear probing)
+    if (2 * (table->len + 1) > table->entries.size()) {
+        hash_table_grow(table);
+    }
+    auto &entry = table->entries[hash_table_slot(table, key)];
+    if (entry.key == HASH_TABLE_EMPTY_KEY) {
+        entry.key = key;
+        entry.value = V{};
+        table->len += 1;
+    }
+    return entry.value;
+}
+
+template <typename V>
+bool hash_table_contains(HashTable<V> const *table, uint32_t key) {
+    return hash_table_find(table, key) != nullptr;
+}
+
+// calls `fun(key, value)` on each entry (in an unspecified order)
+template <typename V, typename F>
+void hash_table_for_each(HashTable<V> const *table, F const &fun) {
+    for (auto const &entry : table->entries) {
+        if (entry.key != HASH_TABLE_EMPTY_KEY) {
+            fun(entry.key, entry.value);
+        }
+    }
+}
+
+#endif
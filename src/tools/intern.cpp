@@ -0,0 +1,82 @@
+#include "intern.hpp"
+#include "mem.hpp"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+struct InternTable {
+    std::shared_mutex mutex;
+    Arena arena = arena_create();
+    // the keys are views on the bytes stored in the arena
+    std::unordered_map<std::string_view, IdentifierId> ids;
+    std::vector<Identifier> identifiers;
+
+    InternTable() {
+        ids.emplace("", IDENTIFIER_EMPTY);
+        identifiers.push_back(Identifier{IDENTIFIER_EMPTY, 0, ""});
+    }
+
+    ~InternTable() {
+        arena_destroy(&arena);
+    }
+};
+
+static InternTable &intern_table() {
+    static InternTable table;
+    return table;
+}
+
+Identifier intern(std::string_view str) {
+    auto &table = intern_table();
+
+    // most of the identifiers are already in the table (the lookup does not
+    // block the other threads)
+    {
+        std::shared_lock lock(table.mutex);
+        auto it = table.ids.find(str);
+        if (it != table.ids.end()) {
+            return table.identifiers[it->second];
+        }
+    }
+
+    std::unique_lock lock(table.mutex);
+    auto it = table.ids.find(str);
+    if (it != table.ids.end()) {
+        return table.identifiers[it->second];
+    }
+    auto ptr = (char *)arena_alloc_no_zero(&table.arena, str.size() + 1, 1);
+    memcpy(ptr, str.data(), str.size());
+    ptr[str.size()] = 0;
+    Identifier identifier = {
+        .id = (IdentifierId)table.identifiers.size(),
+        .len = (uint32_t)str.size(),
+        .ptr = ptr,
+    };
+    table.identifiers.push_back(identifier);
+    table.ids.emplace(std::string_view(ptr, str.size()), identifier.id);
+    return identifier;
+}
+
+Identifier intern_lookup(IdentifierId id) {
+    auto &table = intern_table();
+    std::shared_lock lock(table.mutex);
+    return table.identifiers[id];
+}
+
+size_t intern_count() {
+    auto &table = intern_table();
+    std::shared_lock lock(table.mutex);
+    return table.identifiers.size();
+}
+
+void intern_reset() {
+    auto &table = intern_table();
+    std::unique_lock lock(table.mutex);
+    table.ids.clear();
+    table.identifiers.clear();
+    arena_destroy(&table.arena);
+    table.arena = arena_create();
+    table.ids.emplace("", IDENTIFIER_EMPTY);
+    table.identifiers.push_back(Identifier{IDENTIFIER_EMPTY, 0, ""});
+}
@@ -0,0 +1,40 @@
+#ifndef TOOLS_INTERN
+#define TOOLS_INTERN
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*
+ * Global identifier table. Each distinct identifier is mapped to a stable 32
+ * bits id and its bytes are stored once (null terminated) in an arena, so the
+ * symbol tables can use integer keys and the identifiers can be copied freely
+ * in the asts. The table is shared by all the compilation units (and by the
+ * requests of the server), the ids are only released when the whole table is
+ * reset (the server does it between two requests when the table is large).
+ */
+
+using IdentifierId = uint32_t;
+
+// id of the empty identifier (a value initialized identifier is empty, which
+// is used for the unnamed type specifiers)
+#define IDENTIFIER_EMPTY 0
+
+// a trivialy copyable type to use in the asts
+struct Identifier {
+    IdentifierId id;
+    uint32_t len;
+    char const *ptr; // interned bytes (null terminated)
+
+    std::string_view view() const { return std::string_view(ptr, len); }
+    bool operator==(Identifier const &other) const { return id == other.id; }
+    bool operator!=(Identifier const &other) const { return id != other.id; }
+};
+
+Identifier intern(std::string_view str);
+Identifier intern_lookup(IdentifierId id);
+// number of identifiers in the table (including the empty one)
+size_t intern_count();
+// must not be called while identifiers are used
+void intern_reset();
+
+#endif
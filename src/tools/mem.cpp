@@ -1,61 +1,31 @@
 #include "mem.hpp"
 #include <cassert>
 #include <algorithm>
+#include <iomanip>
 
 /******************************************************************************/
 /*                                   arena                                    */
 /******************************************************************************/
 
-static bool is_power_of_two(uintptr_t x) {
-    return (x & (x-1)) == 0;
-}
-
-static uintptr_t align_forward(uintptr_t ptr, size_t align) {
-    assert(is_power_of_two(align));
-    uintptr_t a = (uintptr_t)align;
-    uintptr_t mod = ptr & (a - 1);
-    if (mod != 0) {
-        ptr += a - mod;
-    }
-    return ptr;
-}
-
-ArenaRegion *arena_region_create(size_t size) {
-    // TODO: might want to use malloc and allocate the buffer at the same time
-    ArenaRegion *region = new ArenaRegion{};
+static ArenaRegion *arena_region_create(size_t size) {
+    auto region = (ArenaRegion*)malloc(sizeof(ArenaRegion) + size);
     assert(region != nullptr && "error: failed to create arena region.");
-
-    region->size = size;
-    region->mem = new char[size];
     region->next = nullptr;
-    region->prev = nullptr;
-    assert(region->mem != nullptr && "error: failed to allocate arena region memory.");
+    region->size = size;
     return region;
 }
 
-void arena_region_destroy(ArenaRegion *region) {
-    delete[] region->mem;
-    delete region;
-}
-
-void *arena_region_alloc(ArenaRegion *region, size_t size, size_t align) {
-    uintptr_t addr = align_forward((uintptr_t)&region->mem[region->pos], align);
-    size_t pos = (size_t)(addr - (uintptr_t)region->mem);
-
-    if (pos + size <= region->size) {
-        void *ptr = &region->mem[pos];
-        region->pos = pos + size;
-        memset(ptr, 0, size);
-        return ptr;
-    }
-    return nullptr;
+static void arena_use_region(Arena *arena, ArenaRegion *region) {
+    arena->curr = region;
+    arena->pos = (char*)(region + 1);
+    arena->end = arena->pos + region->size;
 }
 
 Arena arena_create(size_t default_region_size) {
     Arena arena;
     arena.default_region_size = default_region_size;
     arena.head = arena_region_create(default_region_size);
-    arena.tail = arena.head;
+    arena_use_region(&arena, arena.head);
     return arena;
 }
 
@@ -63,35 +33,241 @@ void arena_destroy(Arena *arena) {
     ArenaRegion *cur = arena->head;
     while (cur != nullptr) {
         ArenaRegion *next = cur->next;
-        arena_region_destroy(cur);
+        free(cur);
         cur = next;
     }
+    *arena = Arena{};
 }
 
-// TODO: the current implemantation loops through all the regions to find the
-//       first one that has sufficient space for the allocation. It would be
-//       better if the head pointer was moved whenever a region is full.
-void *arena_alloc(Arena *arena, size_t size, size_t align = DEFAULT_ALIGN) {
-    ArenaRegion *region = nullptr;
+// the regions are kept so the memory can be reused without new allocations
+void arena_reset(Arena *arena) {
+    if (arena->head != nullptr) {
+        arena_use_region(arena, arena->head);
+    }
+}
 
-    // look for a region that can hold this size
-    // TODO: move the head when a region is nearly full
-    if (size < arena->default_region_size) {
-        region = arena->head;
-        while (region != nullptr) {
-            void *ptr = arena_region_alloc(region, size, align);
-            if (ptr != nullptr) {
-                return ptr;
-            }
-            region = region->next;
+// Called when the current region is full: the allocation is done in the next
+// region that is big enough, or in a new region inserted after the current one
+// (the skipped regions are reused after a reset or a rewind).
+void *arena_alloc_slow(Arena *arena, size_t size, size_t align) {
+    size_t required = size + align - 1;
+    ArenaRegion *region = arena->curr != nullptr ? arena->curr->next : nullptr;
+
+    while (region != nullptr && region->size < required) {
+        region = region->next;
+    }
+    if (region == nullptr) {
+        region = arena_region_create(std::max(arena->default_region_size, required));
+        if (arena->curr == nullptr) {
+            region->next = arena->head;
+            arena->head = region;
+        } else {
+            region->next = arena->curr->next;
+            arena->curr->next = region;
         }
     }
-    // allocate a new region
-    region = arena_region_create(std::max(arena->default_region_size, size));
-    arena->tail->next = region;
-    region->prev = arena->tail;
-    arena->tail = region;
-    void *ptr = arena_region_alloc(region, size, align);
-    assert(ptr && "arena_region_alloc return nullptr");
+    arena_use_region(arena, region);
+    void *ptr = arena_alloc_no_zero(arena, size, align);
+    assert(ptr != nullptr);
+    return ptr;
+}
+
+// The block is grown or shrunk in place when it is the last allocation of the
+// current region (the common case when an array is built), otherwise the
+// content is copied in a new block (the old one is released with the arena).
+void *arena_resize(Arena *arena, void *ptr, size_t old_size, size_t new_size,
+                   size_t align) {
+    if (ptr != nullptr && (char*)ptr + old_size == arena->pos &&
+        new_size <= old_size + (size_t)(arena->end - arena->pos)) {
+        arena->pos = (char*)ptr + new_size;
+        return ptr;
+    }
+    if (new_size <= old_size) {
+        return ptr;
+    }
+    void *new_ptr = arena_alloc_no_zero(arena, new_size, align);
+    if (ptr != nullptr) {
+        memcpy(new_ptr, ptr, old_size);
+    }
+    return new_ptr;
+}
+
+/******************************************************************************/
+/*                             tracking allocator                             */
+/******************************************************************************/
+
+void tracking_allocator_init(TrackingAllocator *tracking, Allocator inner) {
+    tracking->inner = inner;
+    tracking_allocator_clear(tracking);
+}
+
+void tracking_allocator_set_tag(TrackingAllocator *tracking, std::string const &tag) {
+    tracking->curr_stats = &tracking->stats[tag];
+}
+
+void tracking_allocator_clear(TrackingAllocator *tracking) {
+    tracking->stats.clear();
+    tracking->blocks.clear();
+    tracking_allocator_set_tag(tracking, "default");
+}
+
+static size_t histogram_class(size_t size) {
+    size_t idx = 0;
+    while (size != 0 && idx + 1 < ALLOC_HISTOGRAM_SIZE) {
+        size >>= 1;
+        idx += 1;
+    }
+    return idx;
+}
+
+// When the inner allocator is an arena, the frees do nothing (the bytes stay
+// in the arena) and the padding inserted before the blocks can be measured.
+static Arena *inner_arena(TrackingAllocator *tracking) {
+    if (tracking->inner.functions != &arena_allocator_functions) {
+        return nullptr;
+    }
+    return (Arena*)tracking->inner.data;
+}
+
+// bytes skipped by the arena to align the block (`pos` and `end` are taken
+// before the allocation, a block in a new region has no padding)
+static size_t arena_padding(char const *pos, char const *end, void *ptr) {
+    if (pos == nullptr || (char*)ptr < pos || (char*)ptr > end) {
+        return 0;
+    }
+    return (size_t)((char*)ptr - pos);
+}
+
+static void record_allocation(TrackingAllocator *tracking, void *ptr,
+                              size_t size) {
+    auto stats = tracking->curr_stats;
+
+    stats->allocations += 1;
+    stats->allocated_bytes += size;
+    stats->live_bytes += size;
+    stats->high_water_mark = std::max(stats->high_water_mark, stats->live_bytes);
+    stats->histogram[histogram_class(size)] += 1;
+    tracking->blocks[ptr] = {size, stats};
+}
+
+// the bytes of a block freed in an arena are still used (they are retained)
+static void record_free(TrackingAllocator *tracking, AllocStats *stats,
+                        size_t size) {
+    stats->frees += 1;
+    if (inner_arena(tracking) != nullptr) {
+        stats->retained_bytes += size;
+    } else {
+        stats->freed_bytes += size;
+        stats->live_bytes -= size;
+    }
+}
+
+void *tracking_allocator_alloc(void *data, size_t size, size_t align) {
+    auto tracking = (TrackingAllocator*)data;
+    Arena *arena = inner_arena(tracking);
+    char *pos = arena != nullptr ? arena->pos : nullptr;
+    char *end = arena != nullptr ? arena->end : nullptr;
+    void *ptr = alloc(tracking->inner, size, align);
+
+    tracking->curr_stats->alignment_waste += arena_padding(pos, end, ptr);
+    record_allocation(tracking, ptr, size);
     return ptr;
 }
+
+void tracking_allocator_free(void *data, void *ptr) {
+    auto tracking = (TrackingAllocator*)data;
+    auto it = tracking->blocks.find(ptr);
+
+    free(tracking->inner, ptr);
+    if (it == tracking->blocks.end()) {
+        return; // nullptr or block allocated before the tracking
+    }
+    auto [size, stats] = it->second;
+    record_free(tracking, stats, size);
+    tracking->blocks.erase(it);
+}
+
+// Recorded as a free of the old block followed by an allocation, except when
+// the arena resizes the last block in place (only the difference is used).
+void *tracking_allocator_resize(void *data, void *ptr, size_t old_size,
+                                size_t new_size, size_t align) {
+    auto tracking = (TrackingAllocator*)data;
+    Arena *arena = inner_arena(tracking);
+    char *pos = arena != nullptr ? arena->pos : nullptr;
+    char *end = arena != nullptr ? arena->end : nullptr;
+    auto it = tracking->blocks.find(ptr);
+    void *new_ptr = resize(tracking->inner, ptr, old_size, new_size, align);
+
+    if (it == tracking->blocks.end()) {
+        tracking->curr_stats->alignment_waste += arena_padding(pos, end, new_ptr);
+        record_allocation(tracking, new_ptr, new_size);
+        return new_ptr;
+    }
+    auto [size, stats] = it->second;
+    tracking->blocks.erase(it);
+    if (arena != nullptr && new_ptr == ptr && (char*)ptr + old_size == pos) {
+        stats->live_bytes -= size;
+    } else if (arena != nullptr && new_ptr == ptr) {
+        // shrunk in place, the end of the block is retained
+        stats->retained_bytes += size - new_size;
+        stats->live_bytes -= new_size;
+    } else {
+        record_free(tracking, stats, size);
+        tracking->curr_stats->alignment_waste += arena_padding(pos, end, new_ptr);
+    }
+    record_allocation(tracking, new_ptr, new_size);
+    return new_ptr;
+}
+
+// the high water marks are summed (upper bound when the sources are used
+// concurrently)
+void alloc_stats_merge(std::map<std::string, AllocStats> &dst,
+                       std::map<std::string, AllocStats> const &src) {
+    for (auto const &[tag, stats] : src) {
+        auto &dst_stats = dst[tag];
+        dst_stats.allocations += stats.allocations;
+        dst_stats.allocated_bytes += stats.allocated_bytes;
+        dst_stats.frees += stats.frees;
+        dst_stats.freed_bytes += stats.freed_bytes;
+        dst_stats.retained_bytes += stats.retained_bytes;
+        dst_stats.alignment_waste += stats.alignment_waste;
+        dst_stats.live_bytes += stats.live_bytes;
+        dst_stats.high_water_mark += stats.high_water_mark;
+        for (size_t i = 0; i < ALLOC_HISTOGRAM_SIZE; ++i) {
+            dst_stats.histogram[i] += stats.histogram[i];
+        }
+    }
+}
+
+void alloc_stats_print(std::ostream &os,
+                       std::map<std::string, AllocStats> const &stats) {
+    os << std::left << std::setw(10) << "tag" << std::right << std::setw(8)
+       << "allocs" << std::setw(10) << "bytes" << std::setw(8) << "frees"
+       << std::setw(12) << "freed bytes" << std::setw(10) << "retained"
+       << std::setw(12) << "align waste"
+       << std::setw(12) << "high water" << std::endl;
+    for (auto const &[tag, tag_stats] : stats) {
+        if (tag_stats.allocations == 0) {
+            continue;
+        }
+        os << std::left << std::setw(10) << tag << std::right << std::setw(8)
+           << tag_stats.allocations << std::setw(10) << tag_stats.allocated_bytes
+           << std::setw(8) << tag_stats.frees << std::setw(12)
+           << tag_stats.freed_bytes << std::setw(10) << tag_stats.retained_bytes
+           << std::setw(12) << tag_stats.alignment_waste
+           << std::setw(12) << tag_stats.high_water_mark << std::endl;
+        os << "  sizes:";
+        for (size_t i = 0; i < ALLOC_HISTOGRAM_SIZE; ++i) {
+            if (tag_stats.histogram[i] == 0) {
+                continue;
+            }
+            if (i + 1 == ALLOC_HISTOGRAM_SIZE) {
+                os << " >=" << ((size_t)1 << (i - 1));
+            } else {
+                os << " <" << ((size_t)1 << i);
+            }
+            os << ":" << tag_stats.histogram[i];
+        }
+        os << std::endl;
+    }
+}
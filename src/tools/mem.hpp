@@ -4,35 +4,56 @@
 #include <cstring>
 #include <cstdint>
 #include <cstdlib>
+#include <map>
+#include <new>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #define DEFAULT_ALIGN 2*sizeof(void*)
-#define DEFAULT_ALLOCATOR Allocator{   \
-        .alloc = heap_allocator_alloc, \
-        .free = heap_allocator_free,   \
-        .data = nullptr,               \
+#define DEFAULT_ALLOCATOR Allocator{           \
+        .functions = &heap_allocator_functions, \
+        .data = nullptr,                        \
     }
 
 /******************************************************************************/
 /*                                 allocator                                  */
 /******************************************************************************/
 
-struct Allocator {
+struct AllocatorFunctions {
     void *(*alloc)(void*, size_t, size_t);
     void (*free)(void*, void*);
+    // (data, ptr, old_size, new_size, align): like realloc, the content is
+    // kept and the block may be moved
+    void *(*resize)(void*, void*, size_t, size_t, size_t);
+};
+
+// The functions are shared by all the allocators of the same kind (the
+// allocator is stored in each array and string of the asts, so it is kept
+// small).
+struct Allocator {
+    AllocatorFunctions const *functions;
     void *data;
 };
 
 inline void *alloc(Allocator &allocator, size_t size, size_t align = DEFAULT_ALIGN) {
-    return allocator.alloc(allocator.data, size, align);
+    return allocator.functions->alloc(allocator.data, size, align);
 }
 
 template <typename T>
 inline T *alloc(Allocator &allocator, size_t size = 1, size_t align = DEFAULT_ALIGN) {
-    return (T*)allocator.alloc(allocator.data, sizeof(T) * size, align);
+    return (T*)allocator.functions->alloc(allocator.data, sizeof(T) * size, align);
 }
 
 inline void free(Allocator &allocator, void *ptr) {
-    allocator.free(allocator.data, ptr);
+    allocator.functions->free(allocator.data, ptr);
+}
+
+inline void *resize(Allocator &allocator, void *ptr, size_t old_size,
+                    size_t new_size, size_t align = DEFAULT_ALIGN) {
+    return allocator.functions->resize(allocator.data, ptr, old_size, new_size, align);
 }
 
 /******************************************************************************/
@@ -47,47 +68,171 @@ inline void heap_allocator_free(void*, void *ptr) {
     free(ptr);
 }
 
+inline void *heap_allocator_resize(void*, void *ptr, size_t, size_t new_size, size_t) {
+    return realloc(ptr, new_size);
+}
+
+inline constexpr AllocatorFunctions heap_allocator_functions = {
+    .alloc = heap_allocator_alloc,
+    .free = heap_allocator_free,
+    .resize = heap_allocator_resize,
+};
+
 /******************************************************************************/
 /*                                   arena                                    */
 /******************************************************************************/
 
+/*
+ * Bump allocator. The memory is allocated by regions (the header and the
+ * memory of a region are allocated at once) and the allocations are only done
+ * in the current region. When it is full, the next region is used (or a new
+ * one is inserted after it). The regions are kept when the arena is reset or
+ * rewound, so they can be reused.
+ */
+
 struct ArenaRegion {
-    size_t pos = 0;
-    size_t size = 0;
-    char *mem = nullptr;
-    ArenaRegion *next = nullptr;
-    ArenaRegion *prev = nullptr;
+    ArenaRegion *next;
+    size_t size; // size of the memory that follows the header
 };
 
-// TODO: I may not need all of this
-ArenaRegion *arena_region_create(size_t size);
-void  arena_region_destroy(ArenaRegion *region);
-void *arena_region_alloc(ArenaRegion *region, size_t size, size_t align);
-
-// TODO: improve this implementation
 struct Arena {
     ArenaRegion *head = nullptr;
-    ArenaRegion *tail = nullptr;
+    ArenaRegion *curr = nullptr; // region used for the allocations
+    char *pos = nullptr;         // next free byte in the current region
+    char *end = nullptr;         // end of the current region
     size_t default_region_size = 0;
 };
 
+// position in the arena (the allocations done after the mark can be released
+// by rewinding the arena to it)
+struct ArenaMark {
+    ArenaRegion *region;
+    char *pos;
+};
+
 #define ARENA_DEFAULT_REGION_SIZE (32*1024)
 Arena arena_create(size_t default_region_size = ARENA_DEFAULT_REGION_SIZE);
 void arena_destroy(Arena *arena);
-void *arena_alloc(Arena *arena, size_t size, size_t align);
+void arena_reset(Arena *arena);
+void *arena_alloc_slow(Arena *arena, size_t size, size_t align);
+
+inline ArenaMark arena_mark(Arena *arena) {
+    return ArenaMark{arena->curr, arena->pos};
+}
+
+inline void arena_rewind(Arena *arena, ArenaMark mark) {
+    if (mark.region == nullptr) {
+        arena_reset(arena);
+        return;
+    }
+    arena->curr = mark.region;
+    arena->pos = mark.pos;
+    arena->end = (char*)(mark.region + 1) + mark.region->size;
+}
+
+// the memory is not initialized
+inline void *arena_alloc_no_zero(Arena *arena, size_t size, size_t align = DEFAULT_ALIGN) {
+    assert((align & (align - 1)) == 0);
+    uintptr_t ptr = ((uintptr_t)arena->pos + (align - 1)) & ~(uintptr_t)(align - 1);
+
+    if (arena->pos != nullptr && ptr <= (uintptr_t)arena->end &&
+        size <= (uintptr_t)arena->end - ptr) {
+        arena->pos = (char*)ptr + size;
+        return (void*)ptr;
+    }
+    return arena_alloc_slow(arena, size, align);
+}
+
+// the memory is set to zero
+inline void *arena_alloc(Arena *arena, size_t size, size_t align = DEFAULT_ALIGN) {
+    return memset(arena_alloc_no_zero(arena, size, align), 0, size);
+}
+
+void *arena_resize(Arena *arena, void *ptr, size_t old_size, size_t new_size,
+                   size_t align = DEFAULT_ALIGN);
 
 inline void  arena_allocator_free(void*, void*) {} // TODO: we may want to be able to free the last element
+// like malloc, the memory is not initialized
 inline void *arena_allocator_alloc(void *arena, size_t size, size_t align) {
-    return arena_alloc((Arena*)arena, size, align);
+    return arena_alloc_no_zero((Arena*)arena, size, align);
 }
+inline void *arena_allocator_resize(void *arena, void *ptr, size_t old_size,
+                                   size_t new_size, size_t align) {
+    return arena_resize((Arena*)arena, ptr, old_size, new_size, align);
+}
+inline constexpr AllocatorFunctions arena_allocator_functions = {
+    .alloc = arena_allocator_alloc,
+    .free = arena_allocator_free,
+    .resize = arena_allocator_resize,
+};
 inline Allocator arena_allocator(Arena *arena) {
     return Allocator{
-        .alloc = arena_allocator_alloc,
-        .free = arena_allocator_free,
+        .functions = &arena_allocator_functions,
         .data = arena,
     };
 }
 
+/******************************************************************************/
+/*                             tracking allocator                             */
+/******************************************************************************/
+
+/*
+ * Wraps another allocator (heap or arena) and records statistics about the
+ * allocations. The statistics are grouped by tag (the tag is changed by the
+ * user, for instance at the beginning of each phase).
+ */
+
+#define ALLOC_HISTOGRAM_SIZE 16 // power of two size classes
+
+struct AllocStats {
+    size_t allocations = 0;
+    size_t allocated_bytes = 0;
+    size_t frees = 0;
+    size_t freed_bytes = 0;
+    // bytes freed to an allocator that does not release them (arena), they
+    // are still counted in the live bytes
+    size_t retained_bytes = 0;
+    // padding inserted by the allocator before the blocks (arena)
+    size_t alignment_waste = 0;
+    size_t live_bytes = 0;
+    size_t high_water_mark = 0;
+    // histogram[i] counts the sizes in [2^(i-1), 2^i) (the last class holds
+    // the bigger sizes)
+    size_t histogram[ALLOC_HISTOGRAM_SIZE] = {};
+};
+
+struct TrackingAllocator {
+    Allocator inner;
+    AllocStats *curr_stats = nullptr;
+    std::map<std::string, AllocStats> stats;
+    // size and tag of the blocks that have not been freed
+    std::unordered_map<void*, std::pair<size_t, AllocStats*>> blocks;
+};
+
+void tracking_allocator_init(TrackingAllocator *tracking, Allocator inner);
+void tracking_allocator_set_tag(TrackingAllocator *tracking, std::string const &tag);
+void tracking_allocator_clear(TrackingAllocator *tracking);
+void *tracking_allocator_alloc(void *tracking, size_t size, size_t align);
+void tracking_allocator_free(void *tracking, void *ptr);
+void *tracking_allocator_resize(void *tracking, void *ptr, size_t old_size,
+                                size_t new_size, size_t align);
+inline constexpr AllocatorFunctions tracking_allocator_functions = {
+    .alloc = tracking_allocator_alloc,
+    .free = tracking_allocator_free,
+    .resize = tracking_allocator_resize,
+};
+inline Allocator tracking_allocator(TrackingAllocator *tracking) {
+    return Allocator{
+        .functions = &tracking_allocator_functions,
+        .data = tracking,
+    };
+}
+
+void alloc_stats_merge(std::map<std::string, AllocStats> &dst,
+                       std::map<std::string, AllocStats> const &src);
+void alloc_stats_print(std::ostream &os,
+                       std::map<std::string, AllocStats> const &stats);
+
 /******************************************************************************/
 /*                                    pool                                    */
 /******************************************************************************/
@@ -100,76 +245,93 @@ T *arena_alloc(Arena *arena, size_t size = 1, size_t align = DEFAULT_ALIGN) {
     return (T*)arena_alloc(arena, size, align);
 }
 
-template <typename T>
-struct MemPoolAst {
-    T data = {};
-    MemPoolAst<T> *prev = nullptr;
-    MemPoolAst<T> *next = nullptr;
+/*
+ * Pool of elements of the same type. The elements are allocated in slabs
+ * (contiguous arrays of `slab_size` elements) and taken with a bump pointer,
+ * so the nodes allocated one after the other are next to each other in
+ * memory. The released elements are kept in a free list and reused first.
+ * The elements are never destroyed (T must be trivially destructible).
+ */
+
+#define MEM_POOL_DEFAULT_SLAB_SIZE 512
+
+// stored in the memory of the released elements
+struct MemPoolFreeNode {
+    MemPoolFreeNode *next;
 };
 
 template <typename T>
 struct MemPool {
-    MemPoolAst<T> *free_list_head = nullptr;
-    MemPoolAst<T> *used_list_head = nullptr;
+    std::vector<T*> slabs;
+    size_t slab_size = MEM_POOL_DEFAULT_SLAB_SIZE;
+    size_t used_slabs = 0;
+    T *curr = nullptr; // next element of the current slab
+    T *end = nullptr;  // end of the current slab
+    MemPoolFreeNode *free_list_head = nullptr;
 };
 
-template <typename T, typename ...Args>
-void mem_pool_init(MemPool<T> *pool, size_t default_capacity = 0) {
+template <typename T>
+void mem_pool_init(MemPool<T> *pool, size_t slab_size = MEM_POOL_DEFAULT_SLAB_SIZE) {
+    static_assert(std::is_trivially_destructible_v<T>);
+    static_assert(sizeof(T) >= sizeof(MemPoolFreeNode));
+    pool->slabs.clear();
+    pool->slab_size = slab_size;
+    pool->used_slabs = 0;
+    pool->curr = nullptr;
+    pool->end = nullptr;
     pool->free_list_head = nullptr;
-    pool->used_list_head = nullptr;
-    for (size_t i = 0; i < default_capacity; ++i) {
-        auto ast = new MemPoolAst<T>();
-        ast->next = pool->free_list_head;
-        pool->free_list_head = ast;
-    }
 }
 
 template <typename T>
 void mem_pool_destroy(MemPool<T> *pool) {
-    auto delete_list = [](MemPoolAst<T> *head) {
-        while (head != nullptr) {
-            auto next = head->next;
-            delete head;
-            head = next;
-        }
-    };
-    delete_list(pool->free_list_head);
-    delete_list(pool->used_list_head);
+    for (T *slab : pool->slabs) {
+        ::operator delete(slab, std::align_val_t(alignof(T)));
+    }
+    pool->slabs.clear();
+    pool->used_slabs = 0;
+    pool->curr = nullptr;
+    pool->end = nullptr;
+    pool->free_list_head = nullptr;
+}
+
+/*
+ * Release all the used elements at once (the slabs are kept so they can be
+ * reused).
+ */
+template <typename T>
+void mem_pool_reset(MemPool<T> *pool) {
+    pool->used_slabs = 0;
+    pool->curr = nullptr;
+    pool->end = nullptr;
+    pool->free_list_head = nullptr;
 }
 
 template <typename T>
 T *mem_pool_alloc(MemPool<T> *pool, T const &value = {}) {
-    MemPoolAst<T> *ast = nullptr;
+    void *mem = nullptr;
 
-    if (pool->free_list_head == nullptr) {
-        pool->free_list_head = new MemPoolAst<T>();
+    if (pool->free_list_head != nullptr) {
+        mem = pool->free_list_head;
+        pool->free_list_head = pool->free_list_head->next;
+        return new (mem) T(value);
     }
-    ast = pool->free_list_head;
-    pool->free_list_head = ast->next;
-    ast->next = pool->used_list_head;
-    if (ast->next != nullptr) {
-        ast->next->prev = ast;
+    if (pool->curr == pool->end) {
+        assert(pool->slab_size > 0);
+        if (pool->used_slabs == pool->slabs.size()) {
+            pool->slabs.push_back((T*)::operator new(
+                sizeof(T) * pool->slab_size, std::align_val_t(alignof(T))));
+        }
+        pool->curr = pool->slabs[pool->used_slabs++];
+        pool->end = pool->curr + pool->slab_size;
     }
-    pool->used_list_head = ast;
-    ast->data = value;
-    return (T*)ast;
+    mem = pool->curr++;
+    return new (mem) T(value);
 }
 
 template <typename T>
 void mem_pool_release(MemPool<T> *pool, T *data) {
-    auto ast = (MemPoolAst<T>*)data;
-    if (ast->prev != nullptr) {
-        ast->prev->next = ast->next;
-    } else {
-        assert(pool->used_list_head = ast);
-        pool->used_list_head = ast->next;
-    }
-    if (ast->next != nullptr) {
-        ast->next->prev = ast->prev;
-    }
-    ast->prev = nullptr;
-    ast->next = pool->free_list_head;
-    pool->free_list_head = ast;
+    auto node = new (data) MemPoolFreeNode{pool->free_list_head};
+    pool->free_list_head = node;
 }
 
 #endif
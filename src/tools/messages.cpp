@@ -1,14 +1,37 @@
 #include "messages.hpp"
 #include <iostream>
+#include <mutex>
 
 namespace msg {
 
+// messages can be reported from multiple threads
+static std::mutex output_mutex;
+static thread_local std::string *capture_buffer = nullptr;
+
 void error(std::string const &msg) {
-    std::cerr << "[" << ERR << "ERROR" << NORM << "]: " << msg << std::endl;
+    print("[" ERR "ERROR" NORM "]: " + msg + "\n");
 }
 
 void warning(std::string const &msg) {
-    std::cerr << "[" << WARN << "WARN" << NORM << "]: " << msg << std::endl;
+    print("[" WARN "WARN" NORM "]: " + msg + "\n");
+}
+
+std::string *capture(std::string *buffer) {
+    std::string *previous = capture_buffer;
+    capture_buffer = buffer;
+    return previous;
+}
+
+void print(std::string const &messages) {
+    if (messages.empty()) {
+        return;
+    }
+    if (capture_buffer != nullptr) {
+        *capture_buffer += messages;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(output_mutex);
+    std::cerr << messages << std::flush;
 }
 
 } // end namespace msg
@@ -14,6 +14,15 @@ namespace msg {
 void error(std::string const &msg);
 void warning(std::string const &msg);
 
+// When `buffer` is not null, the messages reported by the calling thread are
+// appended to it instead of being printed, so the messages of a parallel
+// phase can be printed later in a deterministic order (see print). The
+// previous buffer is returned so captures can be nested.
+std::string *capture(std::string *buffer);
+// print captured messages (they go to the buffer of the calling thread if it
+// is captured too)
+void print(std::string const &messages);
+
 } // end namespace msg
 
 #define ERROR(loc, args)                                                       \
@@ -31,7 +40,7 @@ void warning(std::string const &msg);
 #define QUOTE(val) "'" BOLD << val << NORM "'"
 
 #define UNDEFINED_SYMBOL_ERROR(loc, symbol_id)                                 \
-    ERROR(loc, "undefined symbol " << QUOTE(symbol_id) << ". " << __FILE__ << ":" << __LINE__)
+    ERROR(loc, "undefined symbol " << QUOTE(symbol_id) << ".")
 #define MULTIPLE_DEFINITION_ERROR(loc, name, symbol_location)                  \
     ERROR(loc, "redifinition definition of symbol "                            \
                    << QUOTE(name) << " (previously defined here: '"            \
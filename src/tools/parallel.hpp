@@ -0,0 +1,51 @@
+#ifndef TOOLS_PARALLEL
+#define TOOLS_PARALLEL
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Run `fun(idx)` for each index in [0, count) using at most `jobs` threads.
+ * The indices are distributed dynamically (each worker takes the next index
+ * when it is done), and the calling thread is used as one of the workers.
+ * When `fun` throws, the remaining indices are skipped and the first exception
+ * is rethrown in the calling thread.
+ */
+template <typename F>
+void parallel_for(size_t count, size_t jobs, F const &fun) {
+    std::atomic<size_t> next = 0;
+    std::exception_ptr error = nullptr;
+    std::mutex error_mutex;
+    auto worker = [&]() {
+        try {
+            for (size_t idx = next++; idx < count; idx = next++) {
+                fun(idx);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = count;
+        }
+    };
+    std::vector<std::thread> threads;
+
+    jobs = std::min(std::max(jobs, (size_t)1), count);
+    for (size_t i = 1; i < jobs; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include "process.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+bool process_spawn(std::vector<std::string> const &argv, Process &process) {
+    std::vector<char *> c_argv;
+    posix_spawn_file_actions_t actions;
+    int pipe_fds[2];
+
+    process.pid = -1;
+    process.output_fd = -1;
+    process.output.clear();
+    // O_CLOEXEC: the processes spawned at the same time by other threads must
+    // not inherit the pipe (the reader would wait for them to see the end)
+    if (argv.empty() || pipe2(pipe_fds, O_CLOEXEC) != 0) {
+        return false;
+    }
+    for (auto const &arg : argv) {
+        c_argv.push_back((char *)arg.c_str());
+    }
+    c_argv.push_back(nullptr);
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addclose(&actions, pipe_fds[0]);
+    posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDERR_FILENO);
+    posix_spawn_file_actions_addclose(&actions, pipe_fds[1]);
+    int err = posix_spawnp(&process.pid, c_argv[0], &actions, nullptr,
+                           c_argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(pipe_fds[1]);
+
+    if (err != 0) {
+        close(pipe_fds[0]);
+        process.output = "error: cannot run " + argv[0] + ": " + strerror(err) +
+                         ".\n";
+        return false;
+    }
+    process.output_fd = pipe_fds[0];
+    return true;
+}
+
+// read the output until the process closes the pipe, then get its status
+int process_wait(Process &process) {
+    char buf[4096];
+    int status = 0;
+
+    for (;;) {
+        ssize_t n = read(process.output_fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        process.output.append(buf, (size_t)n);
+    }
+    close(process.output_fd);
+    process.output_fd = -1;
+    while (waitpid(process.pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int process_run(std::vector<std::string> const &argv, std::string &output) {
+    Process process;
+
+    if (!process_spawn(argv, process)) {
+        output = process.output;
+        return -1;
+    }
+    int status = process_wait(process);
+    output = process.output;
+    return status;
+}
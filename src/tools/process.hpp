@@ -0,0 +1,23 @@
+#ifndef TOOLS_PROCESS
+#define TOOLS_PROCESS
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/*
+ * External processes are started with posix_spawn (no shell, the arguments are
+ * given as they are). The output of the process (stdout and stderr) is read
+ * through a pipe so the caller decides where it is reported.
+ */
+
+struct Process {
+    pid_t pid;
+    int output_fd; // read end of the pipe
+    std::string output;
+};
+
+bool process_spawn(std::vector<std::string> const &argv, Process &process);
+int process_wait(Process &process);
+int process_run(std::vector<std::string> const &argv, std::string &output);
+
+#endif
@@ -0,0 +1,196 @@
+#include "server.hpp"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+std::string server_default_socket() {
+    return "/tmp/s3c-" + std::to_string(getuid()) + ".sock";
+}
+
+static bool server_address(std::string const &socket_path, sockaddr_un &addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "error: socket path too long " << socket_path << "."
+                  << std::endl;
+        return false;
+    }
+    memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+    return true;
+}
+
+static bool write_all(int fd, std::string const &data) {
+    size_t pos = 0;
+    while (pos < data.size()) {
+        // MSG_NOSIGNAL: a client that quits must not kill the server
+        ssize_t n = send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        pos += (size_t)n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, std::string &data) {
+    char buf[4096];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        data.append(buf, (size_t)n);
+    }
+}
+
+// the strings of the request are separated by '\0'
+static std::vector<std::string> split_request(std::string const &request) {
+    std::vector<std::string> result;
+    size_t begin = 0;
+    for (size_t end = request.find('\0'); end != std::string::npos;
+         end = request.find('\0', begin)) {
+        result.push_back(request.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return result;
+}
+
+// run the handler in the client directory and capture its output
+static std::string server_handle(std::vector<std::string> const &request,
+                                 ServerHandler const &handler) {
+    std::stringbuf output;
+    int status = 1;
+
+    if (request.empty() || chdir(request[0].c_str()) != 0) {
+        return "1\nerror: invalid request.\n";
+    }
+    auto cout_buf = std::cout.rdbuf(&output);
+    auto cerr_buf = std::cerr.rdbuf(&output);
+    try {
+        status = handler({request.begin() + 1, request.end()});
+    } catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+    }
+    std::cout.rdbuf(cout_buf);
+    std::cerr.rdbuf(cerr_buf);
+    return std::to_string(status) + "\n" + output.str();
+}
+
+// true if a server accepts connections on the socket
+static bool server_alive(sockaddr_un const &addr) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    bool alive = connect(fd, (sockaddr const *)&addr, sizeof(addr)) == 0;
+    close(fd);
+    return alive;
+}
+
+bool server_run(std::string const &socket_path, ServerHandler const &handler) {
+    sockaddr_un addr;
+    if (!server_address(socket_path, addr)) {
+        return false;
+    }
+    // the socket of a running server must not be removed
+    if (server_alive(addr)) {
+        std::cerr << "error: a server is already running on " << socket_path
+                  << "." << std::endl;
+        return false;
+    }
+    int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        std::cerr << "error: cannot create socket: " << strerror(errno) << "."
+                  << std::endl;
+        return false;
+    }
+    unlink(socket_path.c_str()); // remove the socket of a dead server
+    if (bind(server_fd, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(server_fd, SOMAXCONN) != 0) {
+        std::cerr << "error: cannot listen on " << socket_path << ": "
+                  << strerror(errno) << "." << std::endl;
+        close(server_fd);
+        return false;
+    }
+    // the working directory is changed for each request
+    auto server_cwd = std::filesystem::current_path();
+
+    for (bool stop = false; !stop;) {
+        int client_fd = accept(server_fd, nullptr, nullptr);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "error: accept failed: " << strerror(errno) << "."
+                      << std::endl;
+            break;
+        }
+        std::string request_data;
+        if (read_all(client_fd, request_data)) {
+            auto request = split_request(request_data);
+            std::string response;
+            if (request.size() == 2 && request[1] == SERVER_STOP_REQUEST) {
+                response = "0\n";
+                stop = true;
+            } else {
+                response = server_handle(request, handler);
+                std::filesystem::current_path(server_cwd);
+            }
+            write_all(client_fd, response);
+        }
+        close(client_fd);
+    }
+    close(server_fd);
+    unlink(socket_path.c_str());
+    return true;
+}
+
+int server_request(std::string const &socket_path,
+                   std::vector<std::string> const &args) {
+    sockaddr_un addr;
+    if (!server_address(socket_path, addr)) {
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        std::cerr << "error: cannot connect to the server " << socket_path
+                  << ": " << strerror(errno) << "." << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    std::string request = std::filesystem::current_path().string();
+    request.push_back('\0');
+    for (auto const &arg : args) {
+        request += arg;
+        request.push_back('\0');
+    }
+    std::string response;
+    bool ok = write_all(fd, request) && shutdown(fd, SHUT_WR) == 0 &&
+              read_all(fd, response);
+    close(fd);
+
+    size_t status_end = response.find('\n');
+    if (!ok || status_end == std::string::npos) {
+        std::cerr << "error: invalid response from the server." << std::endl;
+        return 1;
+    }
+    std::cerr << response.substr(status_end + 1);
+    return std::atoi(response.substr(0, status_end).c_str());
+}
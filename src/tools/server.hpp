@@ -0,0 +1,24 @@
+#ifndef TOOLS_SERVER
+#define TOOLS_SERVER
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Compile server: the server listens on a local unix socket and runs the
+ * requests one after the other in the same process. A request contains the
+ * working directory of the client and the command line arguments, the
+ * response contains the exit status followed by the diagnostics (everything
+ * written on std::cout and std::cerr while the request is handled).
+ */
+
+#define SERVER_STOP_REQUEST "--server-stop"
+
+using ServerHandler = std::function<int(std::vector<std::string> const &)>;
+
+std::string server_default_socket();
+bool server_run(std::string const &socket_path, ServerHandler const &handler);
+int server_request(std::string const &socket_path,
+                   std::vector<std::string> const &args);
+
+#endif
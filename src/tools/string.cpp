@@ -1,7 +1,7 @@
 #include "string.hpp"
 #include <cstring>
 
-String string_create(std::string const &std_str, Allocator allocator) {
+String string_create(std::string_view std_str, Allocator allocator) {
     size_t len = std_str.size();
     String str = {
         .ptr = alloc<char>(allocator, len + 1),
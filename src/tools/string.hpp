@@ -1,6 +1,7 @@
 #ifndef TOOLS_STRINGS
 #define TOOLS_STRINGS
 #include <string>
+#include <string_view>
 #include <cassert>
 #include "mem.hpp"
 
@@ -25,7 +26,7 @@ struct String {
     }
 };
 
-String string_create(std::string const &str, Allocator allocator = DEFAULT_ALLOCATOR);
+String string_create(std::string_view str, Allocator allocator = DEFAULT_ALLOCATOR);
 String string_create(char const *cstr);
 void   string_destroy(String *str);
 
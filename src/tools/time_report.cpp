@@ -0,0 +1,122 @@
+#include "time_report.hpp"
+#include <iomanip>
+#include <mutex>
+#include <sys/resource.h>
+
+thread_local size_t time_report_counters[(size_t)Counter::Count] = {};
+
+struct PhaseReport {
+    size_t runs;
+    double wall_time; // seconds
+    long max_rss_delta; // kB
+    size_t counters[(size_t)Counter::Count];
+};
+
+static bool report_enabled = false;
+static std::mutex report_mutex;
+static PhaseReport report[(size_t)Phase::Count] = {};
+
+static char const *phase_names[(size_t)Phase::Count] = {
+    "preprocess", "parse", "resolve", "check",
+    "codegen", "asm dump", "encode", "link",
+};
+
+static char const *counter_names[(size_t)Counter::Count] = {
+    "ast_nodes", "types", "scopes", "instructions", "data",
+};
+
+// peak resident set size of the process (kB)
+static long max_rss() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void time_report_enable(bool enable) {
+    report_enabled = enable;
+}
+
+void time_report_clear() {
+    std::lock_guard<std::mutex> lock(report_mutex);
+    for (auto &phase : report) {
+        phase = {};
+    }
+}
+
+PhaseTimer::PhaseTimer(Phase phase) : phase(phase), enabled(report_enabled) {
+    if (!enabled) {
+        return;
+    }
+    start = std::chrono::steady_clock::now();
+    start_max_rss = max_rss();
+    for (size_t i = 0; i < (size_t)Counter::Count; ++i) {
+        start_counters[i] = time_report_counters[i];
+    }
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (!enabled) {
+        return;
+    }
+    std::chrono::duration<double> duration =
+        std::chrono::steady_clock::now() - start;
+    long rss_delta = max_rss() - start_max_rss;
+
+    std::lock_guard<std::mutex> lock(report_mutex);
+    auto &phase_report = report[(size_t)phase];
+    phase_report.runs += 1;
+    phase_report.wall_time += duration.count();
+    phase_report.max_rss_delta += rss_delta;
+    for (size_t i = 0; i < (size_t)Counter::Count; ++i) {
+        phase_report.counters[i] += time_report_counters[i] - start_counters[i];
+    }
+}
+
+void time_report_print(std::ostream &os) {
+    std::lock_guard<std::mutex> lock(report_mutex);
+    double total_time = 0;
+
+    os << std::left << std::setw(16) << "phase" << std::right << std::setw(6)
+       << "runs" << std::setw(12) << "wall (ms)" << std::setw(14)
+       << "peak rss (kB)" << "  counters" << std::endl;
+    for (size_t i = 0; i < (size_t)Phase::Count; ++i) {
+        auto const &phase_report = report[i];
+        if (phase_report.runs == 0) {
+            continue;
+        }
+        total_time += phase_report.wall_time;
+        os << std::left << std::setw(16) << phase_names[i] << std::right
+           << std::setw(6) << phase_report.runs << std::setw(12) << std::fixed
+           << std::setprecision(3) << phase_report.wall_time * 1000
+           << std::setw(14) << phase_report.max_rss_delta << " ";
+        for (size_t c = 0; c < (size_t)Counter::Count; ++c) {
+            if (phase_report.counters[c] != 0) {
+                os << " " << counter_names[c] << "=" << phase_report.counters[c];
+            }
+        }
+        os << std::endl;
+    }
+    os << std::left << std::setw(16) << "total" << std::right << std::setw(18)
+       << total_time * 1000 << std::endl;
+    os << std::defaultfloat;
+}
+
+void time_report_print_json(std::ostream &os) {
+    std::lock_guard<std::mutex> lock(report_mutex);
+
+    os << "{\"phases\": [";
+    for (size_t i = 0; i < (size_t)Phase::Count; ++i) {
+        auto const &phase_report = report[i];
+        os << (i == 0 ? "" : ", ") << "{\"name\": \"" << phase_names[i]
+           << "\", \"runs\": " << phase_report.runs
+           << ", \"wall_time_ms\": " << phase_report.wall_time * 1000
+           << ", \"max_rss_delta_kb\": " << phase_report.max_rss_delta
+           << ", \"counters\": {";
+        for (size_t c = 0; c < (size_t)Counter::Count; ++c) {
+            os << (c == 0 ? "" : ", ") << "\"" << counter_names[c]
+               << "\": " << phase_report.counters[c];
+        }
+        os << "}}";
+    }
+    os << "]}" << std::endl;
+}
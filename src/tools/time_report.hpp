@@ -0,0 +1,62 @@
+#ifndef TOOLS_TIME_REPORT
+#define TOOLS_TIME_REPORT
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+/*
+ * Time report (--time-report): wall time, peak RSS growth and counters for each
+ * phase of the compilation. The values of the units compiled in parallel are
+ * summed.
+ */
+
+enum class Phase {
+    Preprocess,
+    Parse,
+    Resolve,
+    Check,
+    Codegen,
+    AsmDump,
+    Encode, // built-in encoder + ELF writer (replaces `as`)
+    Link,
+    Count,
+};
+
+enum class Counter {
+    AstNodes,
+    Types,
+    Scopes,
+    Instructions,
+    Data,
+    Count,
+};
+
+// The counters are thread local so the increments are cheap. A phase records
+// the difference between the values at its start and at its end.
+extern thread_local size_t time_report_counters[(size_t)Counter::Count];
+
+inline void time_report_count(Counter counter, size_t value = 1) {
+    time_report_counters[(size_t)counter] += value;
+}
+
+void time_report_enable(bool enable);
+void time_report_clear();
+void time_report_print(std::ostream &os);
+void time_report_print_json(std::ostream &os);
+
+/*
+ * Measure the phase from the construction to the destruction of the object
+ * (does nothing when the report is disabled).
+ */
+struct PhaseTimer {
+    Phase phase;
+    bool enabled;
+    std::chrono::steady_clock::time_point start;
+    long start_max_rss;
+    size_t start_counters[(size_t)Counter::Count];
+
+    PhaseTimer(Phase phase);
+    ~PhaseTimer();
+};
+
+#endif
@@ -1,29 +1,156 @@
 #include "type.hpp"
+#include "tools/hash.hpp"
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 
-bool equal(Type const *t1, Type const *t2) {
-    if (t1->kind != t2->kind) {
-        return false;
+#define TYPE_TABLE_MIN_CAPACITY 64
+
+// hash of the fields of the type (the inner types are unique, so their
+// address is hashed)
+static uint64_t type_hash(TypeKind kind, TypeData const &data) {
+    uint64_t hash = hash_bytes(&kind, sizeof(kind));
+    auto add = [&hash](uint64_t value) {
+        hash = hash_bytes(&value, sizeof(value), hash);
+    };
+
+    switch (kind) {
+    case TypeKind::Nil: break;
+    case TypeKind::Primitive: add((uint64_t)data.primitive); break;
+    case TypeKind::Array:
+        add((uint64_t)data.array.element_type);
+        add(data.array.size);
+        add(data.array.dynamic);
+        break;
+    case TypeKind::Obj:
+        for (auto const &field : data.obj.fields) {
+            add(field.name.id);
+            add((uint64_t)field.type);
+        }
+        break;
+    case TypeKind::Function:
+        add((uint64_t)data.function.return_type);
+        for (Type *argument_type : data.function.arguments_types) {
+            add((uint64_t)argument_type);
+        }
+        break;
     }
+    return hash;
+}
 
-    switch (t1->kind) {
-    case TypeKind::Nil:
+static bool type_same_fields(Type const *type, TypeKind kind,
+                             TypeData const &data) {
+    if (type->kind != kind) {
         return false;
-    case TypeKind::Primitive:
-        return t1->data.primitive == t2->data.primitive;
-        break;
+    }
+
+    switch (kind) {
+    case TypeKind::Nil: return true;
+    case TypeKind::Primitive: return type->data.primitive == data.primitive;
     case TypeKind::Array:
-        return t1->data.array.dynamic == t2->data.array.dynamic &&
-               t1->data.array.size == t2->data.array.size &&
-               equal(t1->data.array.element_type, t2->data.array.element_type);
-        break;
-    case TypeKind::Obj: return false;
-    case TypeKind::Function: return false;
+        return type->data.array.element_type == data.array.element_type &&
+               type->data.array.size == data.array.size &&
+               type->data.array.dynamic == data.array.dynamic;
+    case TypeKind::Obj: {
+        auto const &fields = type->data.obj.fields;
+        if (fields.len != data.obj.fields.len) {
+            return false;
+        }
+        for (size_t i = 0; i < fields.len; ++i) {
+            if (fields[i].name != data.obj.fields[i].name ||
+                fields[i].type != data.obj.fields[i].type) {
+                return false;
+            }
+        }
+        return true;
+    }
+    case TypeKind::Function: {
+        auto const &arguments_types = type->data.function.arguments_types;
+        if (type->data.function.return_type != data.function.return_type ||
+            arguments_types.len != data.function.arguments_types.len) {
+            return false;
+        }
+        for (size_t i = 0; i < arguments_types.len; ++i) {
+            if (arguments_types[i] != data.function.arguments_types[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
     }
     return false; // unreachable
 }
 
+static size_t type_table_slot(TypeTable const *table, TypeKind kind,
+                              TypeData const &data) {
+    size_t mask = table->slots.size() - 1;
+    size_t idx = type_hash(kind, data) & mask;
+
+    while (table->slots[idx] != nullptr &&
+           !type_same_fields(table->slots[idx], kind, data)) {
+        idx = (idx + 1) & mask;
+    }
+    return idx;
+}
+
+static void type_table_grow(TypeTable *table) {
+    std::vector<Type *> slots(2 * table->slots.size(), nullptr);
+
+    std::swap(slots, table->slots);
+    for (Type *type : slots) {
+        if (type != nullptr) {
+            table->slots[type_table_slot(table, type->kind, type->data)] = type;
+        }
+    }
+}
+
+Type *intern_type_(TypeTable *table, TypeKind kind, TypeData data) {
+    if (2 * (table->len + 1) > table->slots.size()) {
+        type_table_grow(table);
+    }
+    size_t idx = type_table_slot(table, kind, data);
+
+    if (table->slots[idx] == nullptr) {
+        time_report_count(Counter::Types);
+        table->slots[idx] = mem_pool_alloc(&table->pool, Type{
+            .kind = kind,
+            .data = data,
+        });
+        table->len += 1;
+    }
+    return table->slots[idx];
+}
+
+static void type_table_init_builtins(TypeTable *table) {
+    table->nil = intern_type(table, TypeKind::Nil, {});
+    for (auto primitive : {PrimitiveType::Chr, PrimitiveType::Int,
+                           PrimitiveType::Flt, PrimitiveType::Str}) {
+        table->primitives[(size_t)primitive] =
+            intern_type(table, TypeKind::Primitive, .primitive = primitive);
+    }
+}
+
+void type_table_init(TypeTable *table) {
+    mem_pool_init(&table->pool);
+    table->slots.assign(TYPE_TABLE_MIN_CAPACITY, nullptr);
+    table->len = 0;
+    type_table_init_builtins(table);
+}
+
+void type_table_destroy(TypeTable *table) {
+    mem_pool_destroy(&table->pool);
+    table->slots.clear();
+    table->len = 0;
+}
+
+// the memory of the pool and of the slots is kept
+void type_table_reset(TypeTable *table) {
+    mem_pool_reset(&table->pool);
+    std::fill(table->slots.begin(), table->slots.end(), nullptr);
+    table->len = 0;
+    type_table_init_builtins(table);
+}
+
 bool is_convertible(Type const *from, Type const *to) {
     if (from->kind == TypeKind::Array) {
         if (to->kind != TypeKind::Array) {
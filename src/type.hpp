@@ -2,7 +2,10 @@
 #define TYPE
 #include "tools/string.hpp"
 #include "tools/array.hpp"
+#include "tools/intern.hpp"
 #include "tools/mem.hpp"
+#include "tools/time_report.hpp"
+#include <vector>
 
 struct Type;
 
@@ -24,7 +27,7 @@ struct ArrayType {
 };
 
 struct ObjTypeField {
-    String name;
+    Identifier name;
     Type  *type;
 };
 
@@ -58,15 +61,35 @@ struct Type {
     TypeData data;
 };
 
-inline Type *new_type_(MemPool<Type> *pool, TypeKind kind, TypeData data) {
-    return mem_pool_alloc(pool, Type{
-        .kind = kind,
-        .data = data,
-    });
+/*
+ * The types are hash-consed: each structural type is created once in the
+ * table, and the types that are built from other types (arrays, objects and
+ * functions) refer to the unique instances. Two types are equal if and only
+ * if they are the same pointer. The table is cleared with the state.
+ */
+struct TypeTable {
+    MemPool<Type> pool;
+    std::vector<Type *> slots; // open addressing (nullptr for the free slots)
+    size_t len;
+    Type *nil;
+    Type *primitives[4]; // indexed by PrimitiveType
+};
+
+void type_table_init(TypeTable *table);
+void type_table_destroy(TypeTable *table);
+void type_table_reset(TypeTable *table);
+
+// Return the unique instance of the type (the arrays of the type are not
+// copied, they must outlive the table).
+Type *intern_type_(TypeTable *table, TypeKind kind, TypeData data);
+#define intern_type(table, kind, ...) intern_type_((table), (kind), TypeData{__VA_ARGS__})
+
+inline Type *type_nil(TypeTable *table) { return table->nil; }
+inline Type *type_primitive(TypeTable *table, PrimitiveType primitive) {
+    return table->primitives[(size_t)primitive];
 }
-#define new_type(pool, kind, ...) new_type_((pool), (kind), TypeData{__VA_ARGS__})
 
-bool equal(Type const *t1, Type const *t2);
+inline bool equal(Type const *t1, Type const *t2) { return t1 == t2; }
 bool is_convertible(Type const *from, Type const *to);
 
 bool is_primitive(Type const *type);